@@ -17,7 +17,8 @@
 /*!
     \file charset.cpp
     \brief A converter for UTF-8 to EBU Latin charset according to
-           ETSI TS 101 756 Annex C, used for DLS and Labels.
+           ETSI TS 101 756 Annex C, used for DLS and Labels, and to the
+           other charsets of ETSI TS 101 756 supported for DLS.
 
     \author Matthias P. Braendli
     \author Lindsay Cornell
@@ -25,6 +26,7 @@
 
 #include "charset.h"
 #include <algorithm>
+#include <cstring>
 
 /**********************************************/
 /************* BIG FAT WARNING ****************/
@@ -39,7 +41,7 @@
 #define CHARSET_TABLE_OFFSET 1 // NUL at index 0 cannot be represented
 #define CHARSET_TABLE_ENTRIES (256 - CHARSET_TABLE_OFFSET)
 
-static const char* utf8_encoded_EBU_Latin[CHARSET_TABLE_ENTRIES] = {
+static constexpr const char* utf8_encoded_EBU_Latin[CHARSET_TABLE_ENTRIES] = {
      "Ę", "Į", "Ų", "Ă", "Ė", "Ď", "Ș", "Ț", "Ċ", "\n","\v","Ġ", "Ĺ", "Ż", "Ń",
 "ą", "ę", "į", "ų", "ă", "ė", "ď", "ș", "ț", "ċ", "Ň", "Ě", "ġ", "ĺ", "ż", "\u0082",
 " ", "!", "\"","#", "ł", "%", "&", "'", "(", ")", "*", "+", ",", "-", ".", "/",
@@ -57,70 +59,357 @@ static const char* utf8_encoded_EBU_Latin[CHARSET_TABLE_ENTRIES] = {
 "Ã", "Å", "Æ", "Œ", "ŷ", "Ý", "Õ", "Ø", "Þ", "Ŋ", "Ŕ", "Ć", "Ś", "Ź", "Ť", "ð",
 "ã", "å", "æ", "œ", "ŵ", "ý", "õ", "ø", "þ", "ŋ", "ŕ", "ć", "ś", "ź", "ť", "ħ"};
 
+/*! EBU Latin based common core, Cyrillic, Greek: the upper half holds the
+ * Cyrillic and Greek letters instead of the further Latin characters.
+ * Unassigned characters are empty.
+ */
+static constexpr const char* utf8_encoded_EBU_Latin_Cy_Gr[CHARSET_TABLE_ENTRIES] = {
+     "",  "",  "",  "",  "",  "",  "",  "",  "",  "\n", "\v", "",  "",  "",  "",
+"",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",
+" ", "!", "\"", "#", "ł", "%", "&", "'", "(", ")", "*", "+", ",", "-", ".", "/",
+"0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ":", ";", "<", "=", ">", "?",
+"@", "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O",
+"P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z", "[", "Ů", "]", "Ł", "_",
+"Ą", "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n", "o",
+"p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z", "«", "ů", "»", "Ľ", "Ħ",
+"А", "Б", "В", "Г", "Д", "Е", "Ж", "З", "И", "Й", "К", "Л", "М", "Н", "О", "П",
+"Р", "С", "Т", "У", "Ф", "Х", "Ц", "Ч", "Ш", "Щ", "Ъ", "Ы", "Ь", "Э", "Ю", "Я",
+"а", "б", "в", "г", "д", "е", "ж", "з", "и", "й", "к", "л", "м", "н", "о", "п",
+"р", "с", "т", "у", "ф", "х", "ц", "ч", "ш", "щ", "ъ", "ы", "ь", "э", "ю", "я",
+"ΐ", "Α", "Β", "Γ", "Δ", "Ε", "Ζ", "Η", "Θ", "Ι", "Κ", "Λ", "Μ", "Ν", "Ξ", "Ο",
+"Π", "Ρ", "",  "Σ", "Τ", "Υ", "Φ", "Χ", "Ψ", "Ω", "Ϊ", "Ϋ", "ά", "έ", "ή", "ί",
+"ΰ", "α", "β", "γ", "δ", "ε", "ζ", "η", "θ", "ι", "κ", "λ", "μ", "ν", "ξ", "ο",
+"π", "ρ", "ς", "σ", "τ", "υ", "φ", "χ", "ψ", "ω", "ϊ", "ϋ", "ό", "ύ", "ώ", ""};
+
+/*! EBU Latin based core, Arabic, Hebrew, Cyrillic and Greek: as above, but
+ * only the capital Cyrillic and Greek letters, to make room for the Arabic
+ * and Hebrew ones.
+ */
+static constexpr const char* utf8_encoded_EBU_Latin_Ar_He_Cy_Gr[CHARSET_TABLE_ENTRIES] = {
+     "",  "",  "",  "",  "",  "",  "",  "",  "",  "\n", "\v", "",  "",  "",  "",
+"",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",  "",
+" ", "!", "\"", "#", "ł", "%", "&", "'", "(", ")", "*", "+", ",", "-", ".", "/",
+"0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ":", ";", "<", "=", ">", "?",
+"@", "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K", "L", "M", "N", "O",
+"P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z", "[", "Ů", "]", "Ł", "_",
+"Ą", "a", "b", "c", "d", "e", "f", "g", "h", "i", "j", "k", "l", "m", "n", "o",
+"p", "q", "r", "s", "t", "u", "v", "w", "x", "y", "z", "«", "ů", "»", "Ľ", "Ħ",
+"А", "Б", "В", "Г", "Д", "Е", "Ж", "З", "И", "Й", "К", "Л", "М", "Н", "О", "П",
+"Р", "С", "Т", "У", "Ф", "Х", "Ц", "Ч", "Ш", "Щ", "Ъ", "Ы", "Ь", "Э", "Ю", "Я",
+"Α", "Β", "Γ", "Δ", "Ε", "Ζ", "Η", "Θ", "Ι", "Κ", "Λ", "Μ", "Ν", "Ξ", "Ο", "Π",
+"Ρ", "Σ", "Τ", "Υ", "Φ", "Χ", "Ψ", "Ω", "،", "؛", "؟", "",  "",  "",  "",  "",
+"ء", "آ", "أ", "ؤ", "إ", "ئ", "ا", "ب", "ة", "ت", "ث", "ج", "ح", "خ", "د", "ذ",
+"ر", "ز", "س", "ش", "ص", "ض", "ط", "ظ", "ع", "غ", "ـ", "ف", "ق", "ك", "ل", "م",
+"ن", "ه", "و", "ى", "ي", "א", "ב", "ג", "ד", "ה", "ו", "ז", "ח", "ט", "י", "ך",
+"כ", "ל", "ם", "מ", "ן", "נ", "ס", "ע", "ף", "פ", "ץ", "צ", "ק", "ר", "ש", "ת"};
+
+/*! The reverse tables (code point -> character) are derived from the tables
+ * above at compile time. They are split into pages of 256 code points; only
+ * pages which contain at least one character are present (page 0x00 always
+ * first).
+ */
+
+// Decode the (single) code point of a table entry; 0 if unassigned
+static constexpr uint32_t table_code_point(const char* entry)
+{
+    return
+        (uint8_t) entry[0] < 0x80 ? (uint8_t) entry[0] :
+        (uint8_t) entry[0] < 0xE0 ? (((uint8_t) entry[0] & 0x1F) <<  6) | ((uint8_t) entry[1] & 0x3F) :
+                                    (((uint8_t) entry[0] & 0x0F) << 12) | (((uint8_t) entry[1] & 0x3F) << 6) | ((uint8_t) entry[2] & 0x3F);
+}
+
+// Find the character of a code point in a table; 0 if not representable
+static constexpr uint8_t find_table_char(const char* const* table, uint32_t code_point, size_t index = CHARSET_TABLE_OFFSET)
+{
+    return
+        code_point == 0 || index > CHARSET_TABLE_ENTRIES ? 0 :
+        table_code_point(table[index - CHARSET_TABLE_OFFSET]) == code_point ? index :
+        find_table_char(table, code_point, index + 1);
+}
+
+template<size_t... I> struct index_list {};
+template<size_t N, size_t... I> struct make_index_list : make_index_list<N - 1, N - 1, I...> {};
+template<size_t... I> struct make_index_list<0, I...> { typedef index_list<I...> type; };
+
+struct charset_page_t {
+    uint32_t page;
+    uint8_t chars[256];
+};
+
+template<size_t... I>
+static constexpr charset_page_t make_charset_page(const char* const* table, uint32_t page, index_list<I...>)
+{
+    return charset_page_t{page, { find_table_char(table, (page << 8) | I)... }};
+}
+#define CHARSET_PAGE(table, page) make_charset_page(table, page, make_index_list<256>::type())
+
+static constexpr charset_page_t ebu_latin_reverse_table[] = {
+    CHARSET_PAGE(utf8_encoded_EBU_Latin, 0x00),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin, 0x01),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin, 0x02),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin, 0x20)
+};
+
+static constexpr charset_page_t ebu_latin_cy_gr_reverse_table[] = {
+    CHARSET_PAGE(utf8_encoded_EBU_Latin_Cy_Gr, 0x00),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin_Cy_Gr, 0x01),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin_Cy_Gr, 0x03),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin_Cy_Gr, 0x04)
+};
+
+static constexpr charset_page_t ebu_latin_ar_he_cy_gr_reverse_table[] = {
+    CHARSET_PAGE(utf8_encoded_EBU_Latin_Ar_He_Cy_Gr, 0x00),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin_Ar_He_Cy_Gr, 0x01),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin_Ar_He_Cy_Gr, 0x03),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin_Ar_He_Cy_Gr, 0x04),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin_Ar_He_Cy_Gr, 0x05),
+    CHARSET_PAGE(utf8_encoded_EBU_Latin_Ar_He_Cy_Gr, 0x06)
+};
+
+template<size_t N>
+static constexpr uint8_t lookup_table_char(const charset_page_t (&reverse_table)[N], uint32_t code_point, size_t page_index = 0)
+{
+    return
+        page_index == N ? 0 :
+        reverse_table[page_index].page == (code_point >> 8) ? reverse_table[page_index].chars[code_point & 0xFF] :
+        lookup_table_char(reverse_table, code_point, page_index + 1);
+}
+
+// Every character must map to a code point that maps back to it (i.e. no page is missing)
+template<size_t N>
+static constexpr bool tables_consistent(const char* const* table, const charset_page_t (&reverse_table)[N], size_t index = CHARSET_TABLE_OFFSET)
+{
+    return
+        index > CHARSET_TABLE_ENTRIES ||
+        ((table_code_point(table[index - CHARSET_TABLE_OFFSET]) == 0 ||
+          lookup_table_char(reverse_table, table_code_point(table[index - CHARSET_TABLE_OFFSET])) == index) &&
+         tables_consistent(table, reverse_table, index + 1));
+}
+static_assert(tables_consistent(utf8_encoded_EBU_Latin, ebu_latin_reverse_table),
+        "EBU Latin conversion tables do not round-trip");
+static_assert(tables_consistent(utf8_encoded_EBU_Latin_Cy_Gr, ebu_latin_cy_gr_reverse_table),
+        "EBU Latin/Cyrillic/Greek conversion tables do not round-trip");
+static_assert(tables_consistent(utf8_encoded_EBU_Latin_Ar_He_Cy_Gr, ebu_latin_ar_he_cy_gr_reverse_table),
+        "EBU Latin/Arabic/Hebrew/Cyrillic/Greek conversion tables do not round-trip");
+
+/*! ISO Latin Alphabet No 2 (ISO/IEC 8859-2): code points of the characters
+ * 0xA0 to 0xFF; the characters below are identical to their code points.
+ */
+#define ISO_LATIN_2_TABLE_OFFSET 0xA0
+
+static constexpr uint16_t iso_latin_2_code_points[256 - ISO_LATIN_2_TABLE_OFFSET] = {
+    0x00A0, 0x0104, 0x02D8, 0x0141, 0x00A4, 0x013D, 0x015A, 0x00A7, 0x00A8, 0x0160, 0x015E, 0x0164,
+    0x0179, 0x00AD, 0x017D, 0x017B, 0x00B0, 0x0105, 0x02DB, 0x0142, 0x00B4, 0x013E, 0x015B, 0x02C7,
+    0x00B8, 0x0161, 0x015F, 0x0165, 0x017A, 0x02DD, 0x017E, 0x017C, 0x0154, 0x00C1, 0x00C2, 0x0102,
+    0x00C4, 0x0139, 0x0106, 0x00C7, 0x010C, 0x00C9, 0x0118, 0x00CB, 0x011A, 0x00CD, 0x00CE, 0x010E,
+    0x0110, 0x0143, 0x0147, 0x00D3, 0x00D4, 0x0150, 0x00D6, 0x00D7, 0x0158, 0x016E, 0x00DA, 0x0170,
+    0x00DC, 0x00DD, 0x0162, 0x00DF, 0x0155, 0x00E1, 0x00E2, 0x0103, 0x00E4, 0x013A, 0x0107, 0x00E7,
+    0x010D, 0x00E9, 0x0119, 0x00EB, 0x011B, 0x00ED, 0x00EE, 0x010F, 0x0111, 0x0144, 0x0148, 0x00F3,
+    0x00F4, 0x0151, 0x00F6, 0x00F7, 0x0159, 0x016F, 0x00FA, 0x0171, 0x00FC, 0x00FD, 0x0163, 0x02D9};
+
+#define UNKNOWN_CHAR_UTF8 "⁇"
+
 using namespace std;
 
-CharsetConverter::CharsetConverter()
+/*! Convert UTF-8 to a charset given by its reverse table; runs of ASCII
+ * characters are detected 8 bytes at once and mapped directly.
+ *
+ * \return true, if all characters could be represented
+ */
+template<size_t N>
+static bool encode_table_charset(const charset_page_t (&reverse_table)[N], const char* it, const char* end_it, string& encoded_line)
+{
+    bool lossless = true;
+    encoded_line.reserve(encoded_line.size() + (end_it - it));
+
+    const uint8_t* ascii_table = reverse_table[0].chars;
+    while (it != end_it) {
+        // fast path: map runs of ASCII characters directly, 8 bytes at once
+        while (end_it - it >= 8) {
+            uint64_t chunk;
+            memcpy(&chunk, it, sizeof(chunk));
+            if (chunk & 0x8080808080808080ULL)
+                break;
+
+            for (size_t i = 0; i < sizeof(chunk); i++) {
+                uint8_t c = ascii_table[(uint8_t) it[i]];
+                lossless &= c != 0;
+                encoded_line.push_back(c ? (char) c : ' ');
+            }
+            it += sizeof(chunk);
+        }
+        if (it == end_it)
+            break;
+
+        // Decode and convert a (possibly multi-byte) codepoint
+        uint8_t c = (uint8_t) *it < 0x80 ? ascii_table[(uint8_t) *it++] : lookup_table_char(reverse_table, utf8::next(it, end_it));
+        lossless &= c != 0;
+        encoded_line.push_back(c ? (char) c : ' ');
+    }
+    return lossless;
+}
+
+static string decode_table_charset(const char* const* table, const string& line)
+{
+    string utf8_str;
+    for (const uint8_t c : line) {
+        // Table offset because NUL is not represented
+        if (c >= CHARSET_TABLE_OFFSET && *table[c - CHARSET_TABLE_OFFSET])
+            utf8_str += table[c - CHARSET_TABLE_OFFSET];
+        else
+            utf8_str += UNKNOWN_CHAR_UTF8;
+    }
+    return utf8_str;
+}
+
+static bool encode_iso_latin_2(uint32_t code_point, string& encoded_line)
+{
+    if (code_point > 0 && code_point < ISO_LATIN_2_TABLE_OFFSET) {
+        encoded_line.push_back((char) code_point);
+        return true;
+    }
+    for (size_t i = 0; i < sizeof(iso_latin_2_code_points) / sizeof(iso_latin_2_code_points[0]); i++) {
+        if (iso_latin_2_code_points[i] == code_point) {
+            encoded_line.push_back((char) (i + ISO_LATIN_2_TABLE_OFFSET));
+            return true;
+        }
+    }
+    encoded_line.push_back(' ');
+    return false;
+}
+
+static bool encode_ucs2_be(uint32_t code_point, string& encoded_line)
+{
+    // only the Basic Multilingual Plane (without surrogates) can be represented
+    bool valid = code_point > 0 && code_point <= 0xFFFF && (code_point < 0xD800 || code_point > 0xDFFF);
+    if (!valid)
+        code_point = ' ';
+    encoded_line.push_back((char) (code_point >> 8));
+    encoded_line.push_back((char) (code_point & 0xFF));
+    return valid;
+}
+
+bool CharsetConverter::is_supported(DABCharset charset)
 {
-    /*! Build the converstion table that contains the known code points,
-     * at the indices corresponding to the EBU Latin table
-     */
-    using namespace std;
-    for (size_t i = 0; i < CHARSET_TABLE_ENTRIES; i++) {
-        string table_entry(utf8_encoded_EBU_Latin[i]);
-        string::iterator it = table_entry.begin();
-        uint32_t code_point = utf8::next(it, table_entry.end());
-        m_conversion_table.push_back(code_point);
+    switch (charset) {
+        case DABCharset::COMPLETE_EBU_LATIN:
+        case DABCharset::EBU_LATIN_CY_GR:
+        case DABCharset::EBU_LATIN_AR_HE_CY_GR:
+        case DABCharset::ISO_LATIN_ALPHABET_2:
+        case DABCharset::UCS2_BE:
+        case DABCharset::UTF8:
+            return true;
+        default:
+            return false;
+    }
+}
+
+const char* CharsetConverter::charset_name(DABCharset charset)
+{
+    switch (charset) {
+        case DABCharset::COMPLETE_EBU_LATIN:
+            return "Complete EBU Latin";
+        case DABCharset::EBU_LATIN_CY_GR:
+            return "EBU Latin core, Cyrillic, Greek";
+        case DABCharset::EBU_LATIN_AR_HE_CY_GR:
+            return "EBU Latin core, Arabic, Hebrew, Cyrillic, Greek";
+        case DABCharset::ISO_LATIN_ALPHABET_2:
+            return "ISO Latin Alphabet 2";
+        case DABCharset::UCS2_BE:
+            return "UCS-2 BE";
+        case DABCharset::UTF8:
+            return "UTF-8";
+        default:
+            return nullptr;
     }
 }
 
 std::string CharsetConverter::convert(std::string line_utf8, bool up_to_first_error)
 {
-    string::iterator end_it;
+    const char* it = line_utf8.data();
+    const char* end_it;
 
     if (up_to_first_error) {
         // check for invalid utf-8, we only convert up to the first error
-        end_it = utf8::find_invalid(line_utf8.begin(), line_utf8.end());
+        end_it = utf8::find_invalid(it, it + line_utf8.size());
     }
     else {
-        end_it = line_utf8.end();
+        end_it = it + line_utf8.size();
     }
 
-    // Convert it to utf-32
-    vector<uint32_t> utf32line;
-    utf8::utf8to32(line_utf8.begin(), end_it, back_inserter(utf32line));
-
-    string encoded_line(utf32line.size(), '0');
+    string encoded_line;
+    encode_table_charset(ebu_latin_reverse_table, it, end_it, encoded_line);
+    return encoded_line;
+}
 
-    // Try to convert each codepoint
-    for (size_t i = 0; i < utf32line.size(); i++) {
-        vector<uint32_t>::iterator iter = find(m_conversion_table.begin(),
-                m_conversion_table.end(), utf32line[i]);
-        if (iter != m_conversion_table.end()) {
-            size_t index = std::distance(m_conversion_table.begin(), iter);
+bool CharsetConverter::encode(const std::string& line_utf8, DABCharset charset, std::string& encoded)
+{
+    const char* it = line_utf8.data();
+    const char* end_it = utf8::find_invalid(it, it + line_utf8.size());
+    bool lossless = end_it == it + line_utf8.size();
 
-            encoded_line[i] = (char)(index + CHARSET_TABLE_OFFSET);
-        }
-        else {
-            encoded_line[i] = ' ';
-        }
+    encoded.clear();
+    switch (charset) {
+        case DABCharset::COMPLETE_EBU_LATIN:
+            lossless &= encode_table_charset(ebu_latin_reverse_table, it, end_it, encoded);
+            break;
+        case DABCharset::EBU_LATIN_CY_GR:
+            lossless &= encode_table_charset(ebu_latin_cy_gr_reverse_table, it, end_it, encoded);
+            break;
+        case DABCharset::EBU_LATIN_AR_HE_CY_GR:
+            lossless &= encode_table_charset(ebu_latin_ar_he_cy_gr_reverse_table, it, end_it, encoded);
+            break;
+        case DABCharset::ISO_LATIN_ALPHABET_2:
+            while (it != end_it)
+                lossless &= encode_iso_latin_2(utf8::next(it, end_it), encoded);
+            break;
+        case DABCharset::UCS2_BE:
+            while (it != end_it)
+                lossless &= encode_ucs2_be(utf8::next(it, end_it), encoded);
+            break;
+        case DABCharset::UTF8:
+            encoded.assign(it, end_it);
+            break;
+        default:
+            return false;
     }
-    return encoded_line;
+    return lossless;
 }
 
-std::string CharsetConverter::convert_ebu_to_utf8(const std::string& str)
+std::string CharsetConverter::decode(const std::string& line, DABCharset charset)
 {
     string utf8_str;
-    for (const uint8_t c : str) {
-        // Table offset because NUL is not represented
-        if (c >= CHARSET_TABLE_OFFSET) {
-            string utf8_char(utf8_encoded_EBU_Latin[c - CHARSET_TABLE_OFFSET]);
-            utf8_str += utf8_char;
-        }
-        else {
-            utf8_str += "⁇";
-        }
+    switch (charset) {
+        case DABCharset::COMPLETE_EBU_LATIN:
+            return decode_table_charset(utf8_encoded_EBU_Latin, line);
+        case DABCharset::EBU_LATIN_CY_GR:
+            return decode_table_charset(utf8_encoded_EBU_Latin_Cy_Gr, line);
+        case DABCharset::EBU_LATIN_AR_HE_CY_GR:
+            return decode_table_charset(utf8_encoded_EBU_Latin_Ar_He_Cy_Gr, line);
+        case DABCharset::ISO_LATIN_ALPHABET_2:
+            for (const uint8_t c : line) {
+                if (c == 0)
+                    utf8_str += UNKNOWN_CHAR_UTF8;
+                else
+                    utf8::append(c < ISO_LATIN_2_TABLE_OFFSET ? c : iso_latin_2_code_points[c - ISO_LATIN_2_TABLE_OFFSET], back_inserter(utf8_str));
+            }
+            return utf8_str;
+        case DABCharset::UCS2_BE:
+            // a trailing odd byte is ignored
+            for (size_t i = 0; i + 1 < line.size(); i += 2) {
+                uint32_t code_point = ((uint8_t) line[i] << 8) | (uint8_t) line[i + 1];
+                if (code_point == 0 || (code_point >= 0xD800 && code_point <= 0xDFFF))
+                    utf8_str += UNKNOWN_CHAR_UTF8;
+                else
+                    utf8::append(code_point, back_inserter(utf8_str));
+            }
+            return utf8_str;
+        default:
+            return line;
     }
-
-    return utf8_str;
 }
 
+std::string CharsetConverter::convert_ebu_to_utf8(const std::string& str)
+{
+    return decode_table_charset(utf8_encoded_EBU_Latin, str);
+}
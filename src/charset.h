@@ -17,7 +17,8 @@
 /*!
     \file charset.h
     \brief A converter for UTF-8 to EBU Latin charset according to
-           ETSI TS 101 756 Annex C, used for DLS and Labels.
+           ETSI TS 101 756 Annex C, used for DLS and Labels, and to the
+           other charsets of ETSI TS 101 756 supported for DLS.
 
     \author Matthias P. Braendli
     \author Lindsay Cornell
@@ -30,10 +31,26 @@
 #include <vector>
 #include "utf8.h"
 
+// Charsets from TS 101 756
+enum class DABCharset : uint8_t {
+    COMPLETE_EBU_LATIN      =  0, //!< Complete EBU Latin based repertoire
+    EBU_LATIN_CY_GR         =  1, //!< EBU Latin based common core, Cyrillic, Greek
+    EBU_LATIN_AR_HE_CY_GR   =  2, //!< EBU Latin based core, Arabic, Hebrew, Cyrillic and Greek
+    ISO_LATIN_ALPHABET_2    =  3, //!< ISO Latin Alphabet No 2
+    UCS2_BE                 =  6, //!< ISO/IEC 10646 using UCS-2 transformation format, big endian byte order
+    UTF8                    = 15  //!< ISO/IEC 10646 using UTF-8
+};
+
 class CharsetConverter
 {
     public:
-        CharsetConverter();
+        /*! Whether texts can be converted from/to the given charset by
+         *  encode() and decode().
+         */
+        static bool is_supported(DABCharset charset);
+
+        //! Return a human readable name of the given charset
+        static const char* charset_name(DABCharset charset);
 
         /*! Convert a UTF-8 encoded text line into an EBU Latin encoded byte
          *  stream. If up_to_first_error is set, convert as much text as possible.
@@ -46,7 +63,16 @@ class CharsetConverter
          */
         std::string convert_ebu_to_utf8(const std::string& str);
 
-    private:
-        // Representation of the table in 32-bit unicode
-        std::vector<uint32_t> m_conversion_table;
+        /*! Convert a UTF-8 encoded text line into the given (supported)
+         *  charset. Characters that cannot be represented are replaced by a
+         *  space, and conversion stops at the first invalid UTF-8 sequence.
+         *
+         *  \return true, if the text was converted without any loss
+         */
+        bool encode(const std::string& line_utf8, DABCharset charset, std::string& encoded);
+
+        /*! Convert a text line in the given (supported) charset to UTF-8.
+         *  Invalid input characters are converted to ⁇ (unicode U+2047).
+         */
+        std::string decode(const std::string& line, DABCharset charset);
 };
@@ -23,6 +23,10 @@
 
 #include "common.h"
 
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
 int verbose = 0;
 
 std::vector<std::string> split_string(const std::string &s, const char delimiter) {
@@ -34,3 +38,27 @@ std::vector<std::string> split_string(const std::string &s, const char delimiter
         result.push_back(part);
     return result;
 }
+
+bool parse_int(const std::string &s, int &target) {
+    // the whole string must be a (decimal) number within the range of int
+    if (s.empty())
+        return false;
+
+    char* end;
+    errno = 0;
+    long value = strtol(s.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE || value < INT_MIN || value > INT_MAX)
+        return false;
+
+    target = value;
+    return true;
+}
+
+uint64_t fnv1a_64(const uint8_t* data, size_t len, uint64_t hash) {
+    // FNV-1a (64 bit); the hash of previous data can be continued
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
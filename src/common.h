@@ -42,10 +42,46 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <stdint.h>
 #include <stdio.h>
+#include <sys/stat.h>
 
 
 extern int verbose;
 extern std::vector<std::string> split_string(const std::string &s, const char delimiter);
+extern bool parse_int(const std::string &s, int &target);
+extern uint64_t fnv1a_64(const uint8_t* data, size_t len, uint64_t hash = 0xCBF29CE484222325ULL);
+
+
+// --- file_version_t -----------------------------------------------------------------
+/*! Identifies a certain version of a file by its stat data. Allows to
+ * reuse data derived from a file until the file is changed/replaced.
+ */
+struct file_version_t {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+
+    file_version_t() : dev(0), ino(0), size(-1), mtime() {}
+    file_version_t(const struct stat& file_stat) :
+        dev(file_stat.st_dev),
+        ino(file_stat.st_ino),
+        size(file_stat.st_size),
+        mtime(file_stat.st_mtim)
+    {}
+
+    bool operator==(const file_version_t& other) const {
+        return
+            dev == other.dev &&
+            ino == other.ino &&
+            size == other.size &&
+            mtime.tv_sec == other.mtime.tv_sec &&
+            mtime.tv_nsec == other.mtime.tv_nsec;
+    }
+    bool operator!=(const file_version_t& other) const {
+        return !(*this == other);
+    }
+};
 
 #endif /* COMMON_H_ */
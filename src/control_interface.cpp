@@ -0,0 +1,102 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "config.h"
+#include "control_interface.h"
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+// raw slides can be bigger than the max slide size, as they are processed later
+const size_t ControlInterface::MAX_MESSAGE_SIZE = 1 + 1024 * 1024;
+
+ControlInterface::~ControlInterface()
+{
+    if (m_sock != -1) {
+        close(m_sock);
+        unlink(m_path.c_str());
+    }
+}
+
+void ControlInterface::open(const std::string &path)
+{
+    m_path = path;
+
+    m_sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (m_sock == -1) {
+        throw runtime_error("Control socket creation failed: " + string(strerror(errno)));
+    }
+
+    struct sockaddr_un claddr;
+    memset(&claddr, 0, sizeof(struct sockaddr_un));
+    claddr.sun_family = AF_UNIX;
+    if (m_path.size() >= sizeof(claddr.sun_path)) {
+        throw runtime_error("Control socket path too long: " + m_path);
+    }
+    snprintf(claddr.sun_path, sizeof(claddr.sun_path), "%s", m_path.c_str());
+
+    if (unlink(claddr.sun_path) == -1 and errno != ENOENT) {
+        fprintf(stderr, "Unlinking of socket %s failed: %s\n", claddr.sun_path, strerror(errno));
+    }
+
+    int ret = ::bind(m_sock, (const struct sockaddr *) &claddr, sizeof(struct sockaddr_un));
+    if (ret == -1) {
+        throw runtime_error("Control socket bind failed " + string(strerror(errno)));
+    }
+
+    m_buffer.resize(MAX_MESSAGE_SIZE);
+}
+
+bool ControlInterface::receive_message(control_message_t &message)
+{
+    if (m_sock == -1) {
+        throw logic_error("Uninitialised ControlInterface::receive_message() called");
+    }
+
+    while (true) {
+        ssize_t ret = recv(m_sock, m_buffer.data(), m_buffer.size(), MSG_DONTWAIT | MSG_TRUNC);
+
+        if (ret == -1) {
+            if (errno == EAGAIN
+#if EAGAIN != EWOULDBLOCK
+                    or errno == EWOULDBLOCK
+#endif
+                    or errno == EINTR) {
+                return false;
+            }
+            throw runtime_error(string("Can't receive control data: ") + strerror(errno));
+        }
+
+        // ignore empty/oversized messages
+        if (ret == 0) {
+            continue;
+        }
+        if ((size_t)ret > m_buffer.size()) {
+            fprintf(stderr, "ODR-PadEnc Warning: ignoring oversized control message (%zd bytes)\n", ret);
+            continue;
+        }
+
+        message.type = m_buffer[0];
+        message.data.assign(m_buffer.begin() + 1, m_buffer.begin() + ret);
+        return true;
+    }
+}
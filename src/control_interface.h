@@ -0,0 +1,69 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*! \file control_interface.h
+ *
+ * Receives DLS texts and slides from other programs (e.g. a playout system)
+ * using a UNIX datagram socket, bypassing the filesystem.
+ *
+ * Each datagram contains one message: the message type (1 byte) followed by
+ * the payload.
+ * - CONTROL_MESSAGE_DLS:   content of a DLS file (incl. optional DL Plus
+ *                          parameters), in the charset given by -c
+ * - CONTROL_MESSAGE_SLIDE: image file data (JPEG/PNG)
+ * - CONTROL_MESSAGE_PRIORITY_SLIDE: like CONTROL_MESSAGE_SLIDE, but aborts
+ *                          the other slides in transmission (which are then
+ *                          transmitted again afterwards); priority slides
+ *                          are transmitted in the order received
+ */
+
+#define CONTROL_MESSAGE_DLS 1
+#define CONTROL_MESSAGE_SLIDE 2
+#define CONTROL_MESSAGE_PRIORITY_SLIDE 3
+
+struct control_message_t {
+    uint8_t type;
+    std::vector<uint8_t> data;
+};
+
+class ControlInterface {
+    public:
+        ~ControlInterface();
+
+        /*! Create a new control interface that binds to a socket at path.
+         */
+        void open(const std::string &path);
+
+        /*! Receives a pending message, if present (does not block)
+         *
+         * \return true, if a message was received
+         */
+        bool receive_message(control_message_t &message);
+
+    private:
+        static const size_t MAX_MESSAGE_SIZE;
+
+        std::string m_path;
+        int m_sock = -1;
+        std::vector<uint8_t> m_buffer;
+};
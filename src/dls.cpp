@@ -34,11 +34,21 @@
 const size_t DLSEncoder::MAXDLS = 128; // chars
 const size_t DLSEncoder::DLS_SEG_LEN_PREFIX = 2;
 const size_t DLSEncoder::DLS_SEG_LEN_CHAR_MAX = 16;
+const size_t DLSEncoder::MAXDLSSEGS = 8; // the segment number has 3 bits
 const std::string DLSEncoder::DL_PARAMS_OPEN  = "##### parameters { #####";
 const std::string DLSEncoder::DL_PARAMS_CLOSE = "##### parameters } #####";
 const int DLSEncoder::APPTYPE_START = 2;
 const int DLSEncoder::APPTYPE_CONT = 3;
 const std::string DLSEncoder::REQUEST_REREAD_SUFFIX = ".REQUEST_DLS_REREAD";
+const std::string DLSEncoder::CONTROL_LABEL = "(control socket)";
+const DABCharset DLSEncoder::AUTO_CHARSETS[] = {
+        DABCharset::COMPLETE_EBU_LATIN,
+        DABCharset::ISO_LATIN_ALPHABET_2,
+        DABCharset::EBU_LATIN_CY_GR,
+        DABCharset::EBU_LATIN_AR_HE_CY_GR,
+        DABCharset::UCS2_BE,
+        DABCharset::UTF8
+};
 
 
 
@@ -117,7 +127,11 @@ bool DLSEncoder::parse_dl_param_bool(const std::string &key, const std::string &
 }
 
 bool DLSEncoder::parse_dl_param_int_dl_plus_tag(const std::string &key, const std::string &value, int &target) {
-    int value_int = atoi(value.c_str());
+    int value_int;
+    if (!parse_int(value, value_int)) {
+        fprintf(stderr, "ODR-PadEnc Warning: DL Plus tag parameter '%s' value '%s' invalid - ignored\n", key.c_str(), value.c_str());
+        return false;
+    }
     if (value_int >= 0x00 && value_int <= 0x7F) {
         target = value_int;
         return true;
@@ -126,7 +140,7 @@ bool DLSEncoder::parse_dl_param_int_dl_plus_tag(const std::string &key, const st
     return false;
 }
 
-void DLSEncoder::parse_dl_params(std::ifstream &dls_fstream, DL_STATE &dl_state) {
+void DLSEncoder::parse_dl_params(std::istream &dls_fstream, DL_STATE &dl_state) {
     std::string line;
     while (std::getline(dls_fstream, line)) {
         // return on params close
@@ -189,71 +203,222 @@ void DLSEncoder::parse_dl_params(std::ifstream &dls_fstream, DL_STATE &dl_state)
 }
 
 
-bool DLSEncoder::parseLabel(const std::string& dls_file, const DL_PARAMS& dl_params, DL_STATE& dl_state) {
-    std::vector<std::string> dls_lines;
+std::string DLSEncoder::join_dl_lines(const std::vector<std::string>& dls_lines, DABCharset charset) {
+    std::stringstream ss;
+    for (size_t i = 0; i < dls_lines.size(); i++) {
+        if (i != 0) {
+            if (charset == DABCharset::UCS2_BE)
+                ss << '\0' << '\n';
+            else
+                ss << '\n';
+        }
+
+        ss << dls_lines[i];
+    }
+    return ss.str();
+}
+
+
+bool DLSEncoder::encode_dl_text(const std::vector<std::string>& dls_lines_utf8, DABCharset charset, std::string& dl_text) {
+    bool lossless = true;
+    std::vector<std::string> encoded_lines(dls_lines_utf8.size());
+    for (size_t i = 0; i < dls_lines_utf8.size(); i++)
+        lossless &= charset_converter.encode(dls_lines_utf8[i], charset, encoded_lines[i]);
+
+    dl_text = join_dl_lines(encoded_lines, charset);
+    return lossless;
+}
 
+
+void DLSEncoder::select_dl_charset(const std::vector<std::string>& dls_lines_utf8, DL_STATE& dl_state) {
+    /*! Encode the text in all candidate charsets and use the best one:
+     * - prefer an encoding that keeps the complete text, i.e. is lossless and
+     *   does not need to be shortened
+     * - then the one with the least segments (each costs prefix/CRC/CI overhead)
+     * - then the one with the least bytes
+     *
+     * Ties are resolved in the order of AUTO_CHARSETS, so a charset with
+     * better receiver support wins.
+     */
+    std::tuple<bool, bool, int, size_t> best_rating;
+    bool best_found = false;
+
+    for (const DABCharset charset : AUTO_CHARSETS) {
+        std::string dl_text;
+        bool lossless = encode_dl_text(dls_lines_utf8, charset, dl_text);
+        size_t fitting_len = dls_fitting_len(dl_text, charset);
+        bool shortened = fitting_len < dl_text.size();
+        int seg_count = dls_count(dl_text.substr(0, fitting_len), charset);
+
+        if (verbose >= 2)
+            fprintf(stderr, "ODR-PadEnc DLS charset candidate %s: %zu bytes, %d segments%s%s\n",
+                    CharsetConverter::charset_name(charset), dl_text.size(), seg_count,
+                    lossless ? "" : ", lossy", shortened ? ", shortened" : "");
+
+        std::tuple<bool, bool, int, size_t> rating(!(lossless && !shortened), !lossless, seg_count, dl_text.size());
+        if (!best_found || rating < best_rating) {
+            best_rating = rating;
+            best_found = true;
+            dl_state.dl_charset = charset;
+            dl_state.dl_text = dl_text;
+        }
+    }
+
+    if (verbose)
+        fprintf(stderr, "ODR-PadEnc DLS text will be encoded in %s (%zu bytes, %d segments)\n",
+                CharsetConverter::charset_name(dl_state.dl_charset), dl_state.dl_text.size(), std::get<2>(best_rating));
+    if (std::get<1>(best_rating))
+        fprintf(stderr, "ODR-PadEnc Warning: DLS text contains characters that cannot be represented in any charset\n");
+}
+
+
+void DLSEncoder::shorten_dl_text(DL_STATE& dl_state) {
+    // keep what fits into the max. number of segments (w/o splitting a character)
+    dl_state.dl_text.resize(dls_fitting_len(dl_state.dl_text, dl_state.dl_charset));
+
+    // drop/clip DL Plus tags that no longer match the text
+    int chars = char_count(dl_state.dl_text, dl_state.dl_charset);
+    dl_plus_tags_t tags;
+    for (DL_PLUS_TAG tag : dl_state.dl_plus_tags) {
+        if (tag.content_type != 0) {    // keep DUMMY tags
+            if (tag.start_marker >= chars) {
+                fprintf(stderr, "ODR-PadEnc Warning: DL Plus tag (content type %d) is beyond the shortened DLS text and is omitted\n", tag.content_type);
+                continue;
+            }
+            if (tag.start_marker + tag.length_marker >= chars) {
+                fprintf(stderr, "ODR-PadEnc Warning: DL Plus tag (content type %d) had to be shortened together with the DLS text\n", tag.content_type);
+                tag.length_marker = chars - 1 - tag.start_marker;
+            }
+        }
+        tags.push_back(tag);
+    }
+    dl_state.dl_plus_tags = tags;
+}
+
+
+bool DLSEncoder::parseLabel(const std::string& dls_file, const DL_PARAMS& dl_params, DL_STATE& dl_state) {
     std::ifstream dls_fstream(dls_file);
     if (!dls_fstream.is_open()) {
         std::cerr << "Could not open " << dls_file << std::endl;
         return false;
     }
 
+    parseLabel(dls_fstream, dl_params, dl_state);
+    return true;
+}
+
+
+void DLSEncoder::parseLabel(std::istream& dls_fstream, const DL_PARAMS& dl_params, DL_STATE& dl_state) {
+    std::vector<std::string> dls_lines;
+
     std::string line;
-    // Read and convert lines one by one because the converter doesn't understand
-    // line endings
     while (std::getline(dls_fstream, line)) {
         if (line.empty())
             continue;
         if (line == DL_PARAMS_OPEN) {
             parse_dl_params(dls_fstream, dl_state);
         } else {
-            if (not dl_params.raw_dls && dl_params.charset == DABCharset::UTF8) {
-                dls_lines.push_back(charset_converter.convert(line));
-            }
-            else {
-                dls_lines.push_back(line);
-            }
-            // TODO handle the other charsets accordingly
+            // UCS-2 BE: if from file the first byte of \0\n remains, remove it
+            if (dl_params.charset == DABCharset::UCS2_BE && line.size() % 2)
+                line.resize(line.size() - 1);
+
+            dls_lines.push_back(line);
         }
     }
 
-    std::stringstream ss;
-    for (size_t i = 0; i < dls_lines.size(); i++) {
-        if (i != 0) {
-            if (dl_params.charset == DABCharset::UCS2_BE)
-                ss << '\0' << '\n';
-            else
-                ss << '\n';
+    if (dl_params.raw_dls || (!dl_params.auto_output_charset && dl_params.charset == dl_params.output_charset)) {
+        dl_state.dl_charset = dl_params.charset;
+        dl_state.dl_text = join_dl_lines(dls_lines, dl_state.dl_charset);
+    } else {
+        // Convert lines one by one because the converter doesn't understand
+        // line endings
+        if (dl_params.charset != DABCharset::UTF8) {
+            for (std::string& dls_line : dls_lines)
+                dls_line = charset_converter.decode(dls_line, dl_params.charset);
         }
 
-        // UCS-2 BE: if from file the first byte of \0\n remains, remove it
-        if (dl_params.charset == DABCharset::UCS2_BE && dls_lines[i].size() % 2) {
-            dls_lines[i].resize(dls_lines[i].size() - 1);
+        if (dl_params.auto_output_charset) {
+            select_dl_charset(dls_lines, dl_state);
+        } else {
+            dl_state.dl_charset = dl_params.output_charset;
+            if (!encode_dl_text(dls_lines, dl_state.dl_charset, dl_state.dl_text))
+                fprintf(stderr, "ODR-PadEnc Warning: DLS text contains characters that cannot be represented in charset %s\n",
+                        CharsetConverter::charset_name(dl_state.dl_charset));
         }
+    }
 
-        ss << dls_lines[i];
+    // (as segments end at character boundaries, even less than MAXDLS bytes may need more segments than allowed)
+    if (dls_fitting_len(dl_state.dl_text, dl_state.dl_charset) < dl_state.dl_text.size()) {
+        fprintf(stderr, "ODR-PadEnc Warning: oversized DLS text (%zu bytes) had to be shortened\n", dl_state.dl_text.size());
+        shorten_dl_text(dl_state);
     }
+}
 
-    dl_state.dl_text = ss.str();
-    if (dl_state.dl_text.size() > MAXDLS) {
-        fprintf(stderr, "ODR-PadEnc Warning: oversized DLS text (%zu chars) had to be shortened\n", dl_state.dl_text.size());
-        dl_state.dl_text.resize(MAXDLS);
+
+bool DLSEncoder::parseLabelCached(const std::string& dls_file, const DL_PARAMS& dl_params, DL_STATE& dl_state) {
+    // labels set via setLabel() are not backed by a file
+    auto it = file_cache.find(dls_file);
+    if (it != file_cache.end() && it->second.set_directly) {
+        dl_state = it->second.dl_state;
+        return true;
     }
 
+    // if watched, the file is unchanged as long as no change was notified
+    unsigned long change_count = 0;
+    bool watched = file_watcher && file_watcher->GetChangeCount(dls_file, change_count);
+    if (watched &&
+            it != file_cache.end() &&
+            it->second.watched &&
+            it->second.change_count == change_count &&
+            it->second.MatchesParams(dl_params)) {
+        dl_state = it->second.dl_state;
+        return true;
+    }
+
+    // FIFOs (or files that cannot be stat'ed) have to be read every time
+    struct stat dls_stat;
+    if (stat(dls_file.c_str(), &dls_stat) || !S_ISREG(dls_stat.st_mode))
+        return parseLabel(dls_file, dl_params, dl_state);
+
+    // reuse the already parsed file, if unchanged
+    file_version_t version(dls_stat);
+    if (it != file_cache.end() &&
+            it->second.version == version &&
+            it->second.MatchesParams(dl_params)) {
+        it->second.watched = watched;
+        it->second.change_count = change_count;
+        dl_state = it->second.dl_state;
+        return true;
+    }
+
+    if (!parseLabel(dls_file, dl_params, dl_state)) {
+        file_cache.erase(dls_file);
+        return false;
+    }
+
+    dl_file_cache_entry_t& entry = file_cache[dls_file];
+    entry.version = version;
+    entry.set_directly = false;
+    entry.watched = watched;
+    entry.change_count = change_count;
+    entry.charset = dl_params.charset;
+    entry.output_charset = dl_params.output_charset;
+    entry.auto_output_charset = dl_params.auto_output_charset;
+    entry.raw_dls = dl_params.raw_dls;
+    entry.dl_state = dl_state;
     return true;
 }
 
 
-void DLSEncoder::encodeLabel(const std::string& dls_file, const char* item_state_file, const DL_PARAMS& dl_params) {
-    DL_STATE dl_state;
-    if (!parseLabel(dls_file, dl_params, dl_state))
-        return;
+bool DLSEncoder::getLabel(const std::string& dls_file, const char* item_state_file, const DL_PARAMS& dl_params, DL_STATE& dl_state) {
+    if (!parseLabelCached(dls_file, dl_params, dl_state))
+        return false;
 
     // if enabled, derive DL Plus Item Toggle/Running bits from separate file
     if (item_state_file) {
         DL_STATE item_state;
-        if (!parseLabel(item_state_file, DL_PARAMS(), item_state))
-            return;
+        if (!parseLabelCached(item_state_file, DL_PARAMS(), item_state))
+            return false;
 
         dl_state.dl_plus_enabled = true;
         dl_state.dl_plus_item_toggle = item_state.dl_plus_item_toggle;
@@ -264,10 +429,55 @@ void DLSEncoder::encodeLabel(const std::string& dls_file, const char* item_state
     if (dl_state.dl_plus_enabled && dl_state.dl_plus_tags.empty())
         dl_state.dl_plus_tags.emplace_back();
 
+    return true;
+}
+
+
+void DLSEncoder::setLabel(const std::string& name, const std::string& content, const DL_PARAMS& dl_params) {
+    std::istringstream dls_stream(content);
+    DL_STATE dl_state;
+    parseLabel(dls_stream, dl_params, dl_state);
+
+    dl_file_cache_entry_t& entry = file_cache[name];
+    entry.set_directly = true;
+    entry.dl_state = dl_state;
+}
+
+
+void DLSEncoder::preloadLabels(const std::vector<std::string>& dls_files, const char* item_state_file, const DL_PARAMS& dl_params) {
+    // parse and encode all (regular) DLS files in advance
+    struct stat item_state_stat;
+    if (item_state_file && (stat(item_state_file, &item_state_stat) || !S_ISREG(item_state_stat.st_mode))) {
+        // the item state would have to be read for each label (and a FIFO can be read only once)
+        return;
+    }
+
+    for (const std::string& dls_file : dls_files) {
+        struct stat dls_stat;
+        if (stat(dls_file.c_str(), &dls_stat) || !S_ISREG(dls_stat.st_mode))
+            continue;
+
+        DL_STATE dl_state;
+        if (getLabel(dls_file, item_state_file, dl_params, dl_state))
+            get_dl_dgs(dls_file, dl_state);
+    }
+}
+
+
+void DLSEncoder::encodeLabel(const std::string& dls_file, const DL_STATE& dl_state, const DL_PARAMS& dl_params) {
     // toggle the toggle bit only on new DL state
     bool dl_state_is_new = dl_state != dl_state_prev;
+
+    // if only DL Plus changed (e.g. Item Running bit), the text can be kept
+    // and it is sufficient to send the DL Plus command (see TS 102 980)
+    bool dl_plus_only =
+            dl_state_is_new &&
+            dl_state.dl_plus_enabled &&
+            dl_state.dl_text == dl_state_prev.dl_text &&
+            dl_state.dl_charset == dl_state_prev.dl_charset;
+
     if (verbose) {
-        fprintf(stderr, "ODR-PadEnc writing %s DLS text \"" ODR_COLOR_DL "%s" ODR_COLOR_RST "\"\n", dl_state_is_new ? "new" : "old", dl_state.dl_text.c_str());
+        fprintf(stderr, "ODR-PadEnc writing %s DLS text \"" ODR_COLOR_DL "%s" ODR_COLOR_RST "\"\n", dl_state_is_new && !dl_plus_only ? "new" : "old", charset_converter.decode(dl_state.dl_text, dl_state.dl_charset).c_str());
         if (dl_state.dl_plus_enabled) {
             fprintf(
                     stderr, "ODR-PadEnc writing %s DL Plus tags (IT/IR: %d/%d): ",
@@ -287,34 +497,171 @@ void DLSEncoder::encodeLabel(const std::string& dls_file, const char* item_state
     }
 
     DATA_GROUP *remove_label_dg = NULL;
+    bool send_dl_plus_only = dl_plus_only;
     if (dl_state_is_new) {
-        if (dl_params.remove_dls)
-            remove_label_dg = createDynamicLabelCommand(DLS_CMD_REMOVE_LABEL);
+        // replace the not yet transmitted DGs of the previous label
+        size_t cancelled = pad_packetizer->RemoveUnstartedDGs(APPTYPE_START);
+        if (cancelled) {
+            if (verbose)
+                fprintf(stderr, "ODR-PadEnc replacing previous label in transmission (%zu DGs cancelled)\n", cancelled);
+
+            // the text may not have been transmitted completely
+            send_dl_plus_only = false;
+        }
+
+        if (!dl_plus_only) {
+            if (dl_params.remove_dls)
+                remove_label_dg = createDynamicLabelCommand(DLS_CMD_REMOVE_LABEL);
 
-        dls_toggle = !dls_toggle;   // indicate changed text
+            dls_toggle = !dls_toggle;   // indicate changed text
+        }
 
         dl_state_prev = dl_state;
     }
 
-    prepend_dl_dgs(dl_state, dl_params.raw_dls ? dl_params.charset : DABCharset::COMPLETE_EBU_LATIN);
+    prepend_dl_dgs(dls_file, dl_state, send_dl_plus_only);
     if (remove_label_dg)
         pad_packetizer->AddDG(remove_label_dg, true);
 }
 
 
-int DLSEncoder::dls_count(const std::string& text) {
-    size_t text_len = text.size();
-    return text_len / DLS_SEG_LEN_CHAR_MAX + (text_len % DLS_SEG_LEN_CHAR_MAX ? 1 : 0);
+size_t DLSEncoder::char_boundary(const std::string& text, DABCharset charset, size_t pos) {
+    if (pos >= text.size())
+        return text.size();
+
+    switch (charset) {
+    case DABCharset::UTF8:
+        // skip back over continuation bytes
+        while (pos > 0 && (text[pos] & 0xC0) == 0x80)
+            pos--;
+        return pos;
+    case DABCharset::UCS2_BE:
+        return pos & ~(size_t) 1;
+    default:
+        return pos;
+    }
+}
+
+
+size_t DLSEncoder::char_count(const std::string& text, DABCharset charset) {
+    switch (charset) {
+    case DABCharset::UTF8:
+        return std::count_if(text.begin(), text.end(), [](char c) {return (c & 0xC0) != 0x80;});
+    case DABCharset::UCS2_BE:
+        return text.size() / 2;
+    default:
+        return text.size();
+    }
+}
+
+
+size_t DLSEncoder::dls_seg_len(const std::string& text, DABCharset charset, size_t seg_text_offset) {
+    // use as many bytes as possible, without splitting a character
+    size_t seg_text_len = char_boundary(text, charset, seg_text_offset + DLS_SEG_LEN_CHAR_MAX) - seg_text_offset;
+
+    // (only possible with invalid input)
+    if (seg_text_len == 0)
+        seg_text_len = std::min(text.size() - seg_text_offset, DLS_SEG_LEN_CHAR_MAX);
+    return seg_text_len;
+}
+
+
+std::vector<size_t> DLSEncoder::dls_seg_lens(const std::string& text, DABCharset charset) {
+    if (pad_packetizer->IsShortXPAD()) {
+        std::vector<size_t> seg_lens = dls_seg_lens_short_xpad(text, charset);
+        if (!seg_lens.empty() || text.empty())
+            return seg_lens;
+    }
+
+    // (never more than the max. number of segments; a longer text shall have been shortened before)
+    std::vector<size_t> seg_lens;
+    for (size_t offset = 0; offset < text.size() && seg_lens.size() < MAXDLSSEGS; offset += seg_lens.back())
+        seg_lens.push_back(dls_seg_len(text, charset, offset));
+    return seg_lens;
+}
+
+
+size_t DLSEncoder::dls_fitting_len(const std::string& text, DABCharset charset) {
+    // the longest segments possible also need the least segments
+    size_t offset = 0;
+    for (size_t segs = 0; segs < MAXDLSSEGS && offset < text.size(); segs++)
+        offset += dls_seg_len(text, charset, offset);
+    return offset;
+}
+
+
+std::vector<size_t> DLSEncoder::dls_seg_lens_short_xpad(const std::string& text, DABCharset charset) {
+    /*! At short X-PAD, each X-PAD holds 3 (w/ CI) or 4 (w/o CI) bytes of a DG,
+     * so the last X-PAD of a DG is usually not completely used. Therefore the
+     * segments are chosen to need the least X-PADs in total (e.g. 15 instead
+     * of 16 bytes), rather than being as long as possible - but without
+     * exceeding the max. number of segments.
+     *
+     * Returns no segments, if the text cannot be segmented this way.
+     */
+    const size_t max_segs = MAXDLSSEGS;
+    const size_t none = (size_t) -1;
+
+    // X-PADs needed for the text up to a position, using a number of segments
+    std::vector<std::vector<size_t>> pads(text.size() + 1, std::vector<size_t>(max_segs + 1, none));
+    std::vector<std::vector<size_t>> prev_len(text.size() + 1, std::vector<size_t>(max_segs + 1, 0));
+    pads[0][0] = 0;
+
+    for (size_t pos = 0; pos < text.size(); pos++) {
+        if (char_boundary(text, charset, pos) != pos)
+            continue;
+
+        for (size_t segs = 0; segs < max_segs; segs++) {
+            if (pads[pos][segs] == none)
+                continue;
+
+            // prefer longer segments, if equal
+            for (size_t len = std::min(DLS_SEG_LEN_CHAR_MAX, text.size() - pos); len > 0; len--) {
+                size_t end = pos + len;
+                if (end < text.size() && char_boundary(text, charset, end) != end)
+                    continue;
+
+                size_t end_pads = pads[pos][segs] + PADPacketizer::ShortXPADCount(DLS_SEG_LEN_PREFIX + len + 2);
+                if (end_pads < pads[end][segs + 1]) {
+                    pads[end][segs + 1] = end_pads;
+                    prev_len[end][segs + 1] = len;
+                }
+            }
+        }
+    }
+
+    // use the least X-PADs, then the least segments
+    size_t best_segs = 0;
+    for (size_t segs = 1; segs <= max_segs; segs++)
+        if (pads[text.size()][segs] < (best_segs ? pads[text.size()][best_segs] : none))
+            best_segs = segs;
+    if (best_segs == 0)
+        return std::vector<size_t>();
+
+    std::vector<size_t> seg_lens(best_segs);
+    size_t pos = text.size();
+    for (size_t segs = best_segs; segs > 0; segs--) {
+        seg_lens[segs - 1] = prev_len[pos][segs];
+        pos -= seg_lens[segs - 1];
+    }
+    return seg_lens;
 }
 
 
-DATA_GROUP* DLSEncoder::dls_get(const std::string& text, DABCharset charset, int seg_index) {
+int DLSEncoder::dls_count(const std::string& text, DABCharset charset) {
+    return dls_seg_lens(text, charset).size();
+}
+
+
+DATA_GROUP* DLSEncoder::dls_get(const std::string& text, DABCharset charset, const std::vector<size_t>& seg_lens, int seg_index) {
     bool first_seg = seg_index == 0;
-    bool last_seg  = seg_index == dls_count(text) - 1;
+    bool last_seg  = seg_index == (int) seg_lens.size() - 1;
 
-    int seg_text_offset = seg_index * DLS_SEG_LEN_CHAR_MAX;
+    size_t seg_text_offset = 0;
+    for (int i = 0; i < seg_index; i++)
+        seg_text_offset += seg_lens[i];
     const char *seg_text_start = text.c_str() + seg_text_offset;
-    size_t seg_text_len = std::min(text.size() - seg_text_offset, DLS_SEG_LEN_CHAR_MAX);
+    size_t seg_text_len = seg_lens[seg_index];
 
     DATA_GROUP* dg = new DATA_GROUP(DLS_SEG_LEN_PREFIX + seg_text_len, APPTYPE_START, APPTYPE_CONT);
     uint8_vector_t &seg_data = dg->data;
@@ -345,26 +692,80 @@ DATA_GROUP* DLSEncoder::dls_get(const std::string& text, DABCharset charset, int
 }
 
 
-void DLSEncoder::prepend_dl_dgs(const DL_STATE& dl_state, DABCharset charset) {
-    // process all DL segments
-    int seg_count = dls_count(dl_state.dl_text);
-    std::vector<DATA_GROUP*> segs;
-    for (int seg_index = 0; seg_index < seg_count; seg_index++) {
+void DLSEncoder::set_dg_toggle(DATA_GROUP& dg, bool toggle) {
+    uint8_vector_t &seg_data = dg.data;
+
+    // prefix: toggle
+    seg_data[0] = (seg_data[0] & 0x7F) | (toggle ? (1 << 7) : 0);
+
+    // DL Plus command: link bit
+    if ((seg_data[0] & (1 << 4)) && (seg_data[0] & 0x0F) == DLS_CMD_DL_PLUS)
+        seg_data[1] = (seg_data[1] & 0x7F) | (toggle ? (1 << 7) : 0);
+
+    // CRC
+    seg_data.resize(seg_data.size() - 2);
+    dg.AppendCRC();
+}
+
+
+const dl_dgs_cache_entry_t& DLSEncoder::get_dl_dgs(const std::string& dls_file, const DL_STATE& dl_state) {
+    dl_dgs_cache_entry_t& entry = dgs_cache[dls_file];
+
+    if (entry.dl_state != dl_state || entry.dgs.empty()) {
+        // (re)build the DGs, as the DL state changed
+        entry.dgs.clear();
+
+        // process all DL segments
+        std::vector<size_t> seg_lens = dls_seg_lens(dl_state.dl_text, dl_state.dl_charset);
+        int seg_count = seg_lens.size();
+        size_t seg_text_len = std::accumulate(seg_lens.begin(), seg_lens.end(), (size_t) 0);
+        if (seg_text_len < dl_state.dl_text.size()) {
+            // (the text shall have been shortened before)
+            fprintf(stderr, "ODR-PadEnc Error: DLS text needs more than %zu segments - only the first %zu bytes are sent\n", MAXDLSSEGS, seg_text_len);
+        }
+        for (int seg_index = 0; seg_index < seg_count; seg_index++) {
 #ifdef DEBUG
-        fprintf(stderr, "Segment number %d\n", seg_index + 1);
+            fprintf(stderr, "Segment number %d\n", seg_index + 1);
 #endif
-        segs.push_back(dls_get(dl_state.dl_text, charset, seg_index));
-    }
+            DATA_GROUP* dg = dls_get(dl_state.dl_text, dl_state.dl_charset, seg_lens, seg_index);
+            entry.dgs.push_back(*dg);
+            delete dg;
+        }
 
-    // if enabled, add DL Plus data group
-    if (dl_state.dl_plus_enabled)
-        segs.push_back(createDynamicLabelPlus(dl_state));
+        // if enabled, add DL Plus data group
+        if (dl_state.dl_plus_enabled) {
+            DATA_GROUP* dg = createDynamicLabelPlus(dl_state);
+            entry.dgs.push_back(*dg);
+            delete dg;
+        }
 
-    // prepend to packetizer
-    pad_packetizer->AddDGs(segs, true);
+        entry.dl_state = dl_state;
+        entry.dls_toggle = dls_toggle;
+        entry.pad_count = pad_packetizer->GetPADCount(entry.dgs);
 
 #ifdef DEBUG
-    fprintf(stderr, "DLS text: %s\n", dl_state.dl_text.c_str());
-    fprintf(stderr, "Number of DL segments: %d\n", seg_count);
+        fprintf(stderr, "DLS text: %s\n", dl_state.dl_text.c_str());
+        fprintf(stderr, "Number of DL segments: %d\n", seg_count);
 #endif
+    } else if (entry.dls_toggle != dls_toggle) {
+        // only the toggle bit changed (e.g. when rotating DLS files)
+        for (DATA_GROUP& dg : entry.dgs)
+            set_dg_toggle(dg, dls_toggle);
+        entry.dls_toggle = dls_toggle;
+    }
+
+    return entry;
+}
+
+
+void DLSEncoder::prepend_dl_dgs(const std::string& dls_file, const DL_STATE& dl_state, bool dl_plus_only) {
+    const dl_dgs_cache_entry_t& entry = get_dl_dgs(dls_file, dl_state);
+    const std::vector<DATA_GROUP>& dl_dgs = entry.dgs;
+    dl_dgs_pad_count = entry.pad_count;
+
+    // prepend copies to packetizer (the DL Plus DG is the last one)
+    std::vector<DATA_GROUP*> segs;
+    for (size_t i = dl_plus_only ? dl_dgs.size() - 1 : 0; i < dl_dgs.size(); i++)
+        segs.push_back(new DATA_GROUP(dl_dgs[i]));
+    pad_packetizer->AddDGs(segs, true);
 }
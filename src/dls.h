@@ -30,12 +30,17 @@
 #ifndef DLS_H_
 #define DLS_H_
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <numeric>
+#include <tuple>
 
 #include "common.h"
 #include "pad_common.h"
 #include "charset.h"
+#include "file_watcher.h"
 
 
 // DL/DL+ commands
@@ -50,11 +55,19 @@ enum {
 
 // --- DL_PARAMS -----------------------------------------------------------------
 struct DL_PARAMS {
-    DABCharset charset;
+    DABCharset charset;         // of the input texts
+    DABCharset output_charset;  // used for transmission (unless raw DLS)
+    bool auto_output_charset;   // use the most compact output charset instead
     bool raw_dls;
     bool remove_dls;
 
-    DL_PARAMS() : charset(DABCharset::UTF8), raw_dls(false), remove_dls(false) {}
+    DL_PARAMS() :
+        charset(DABCharset::UTF8),
+        output_charset(DABCharset::COMPLETE_EBU_LATIN),
+        auto_output_charset(false),
+        raw_dls(false),
+        remove_dls(false)
+    {}
 };
 
 
@@ -93,6 +106,7 @@ typedef std::vector<DL_PLUS_TAG> dl_plus_tags_t;
 // --- DL_STATE -----------------------------------------------------------------
 struct DL_STATE {
     std::string dl_text;
+    DABCharset dl_charset;
 
     bool dl_plus_enabled;
     bool dl_plus_item_toggle;
@@ -100,6 +114,7 @@ struct DL_STATE {
     dl_plus_tags_t dl_plus_tags;
 
     DL_STATE() :
+        dl_charset(DABCharset::COMPLETE_EBU_LATIN),
         dl_plus_enabled(false),
         dl_plus_item_toggle(false),
         dl_plus_item_running(false)
@@ -108,6 +123,8 @@ struct DL_STATE {
     bool operator==(const DL_STATE& other) const {
         if (dl_text != other.dl_text)
             return false;
+        if (dl_charset != other.dl_charset)
+            return false;
         if (dl_plus_enabled != other.dl_plus_enabled)
             return false;
         if (dl_plus_enabled) {
@@ -126,37 +143,115 @@ struct DL_STATE {
 };
 
 
+// --- dl_file_cache_entry_t -----------------------------------------------------------------
+/*! The parsed content of a DLS (or item state) file.
+ * It is reused until the file changes.
+ *
+ * Labels set directly (e.g. via the control socket) are stored the same way,
+ * using a name instead of a file path.
+ */
+struct dl_file_cache_entry_t {
+    file_version_t version;
+    bool set_directly;  // not read from a file
+    bool watched;
+    unsigned long change_count;
+    DABCharset charset;
+    DABCharset output_charset;
+    bool auto_output_charset;
+    bool raw_dls;
+    DL_STATE dl_state;
+
+    bool MatchesParams(const DL_PARAMS& dl_params) const {
+        return
+            charset == dl_params.charset &&
+            output_charset == dl_params.output_charset &&
+            auto_output_charset == dl_params.auto_output_charset &&
+            raw_dls == dl_params.raw_dls;
+    }
+};
+
+
+// --- dl_dgs_cache_entry_t -----------------------------------------------------------------
+/*! The encoded DGs of the label of a DLS file, so that rotating between
+ * several DLS files does not require to encode them again.
+ */
+struct dl_dgs_cache_entry_t {
+    DL_STATE dl_state;
+    bool dls_toggle;
+    std::vector<DATA_GROUP> dgs;
+    size_t pad_count;
+
+    dl_dgs_cache_entry_t() : dls_toggle(false), pad_count(0) {}
+};
+
+
 // --- DLSEncoder -----------------------------------------------------------------
 class DLSEncoder {
 private:
     static const size_t MAXDLS;
     static const size_t DLS_SEG_LEN_PREFIX;
     static const size_t DLS_SEG_LEN_CHAR_MAX;
+    static const size_t MAXDLSSEGS;
     static const std::string DL_PARAMS_OPEN;
     static const std::string DL_PARAMS_CLOSE;
+    static const DABCharset AUTO_CHARSETS[];
 
     DATA_GROUP* createDynamicLabelCommand(uint8_t command);
     DATA_GROUP* createDynamicLabelPlus(const DL_STATE& dl_state);
     bool parse_dl_param_bool(const std::string &key, const std::string &value, bool &target);
     bool parse_dl_param_int_dl_plus_tag(const std::string &key, const std::string &value, int &target);
-    void parse_dl_params(std::ifstream &dls_fstream, DL_STATE &dl_state);
-    int dls_count(const std::string& text);
-    DATA_GROUP* dls_get(const std::string& text, DABCharset charset, int seg_index);
-    void prepend_dl_dgs(const DL_STATE& dl_state, DABCharset charset);
+    void parse_dl_params(std::istream &dls_fstream, DL_STATE &dl_state);
+    static size_t char_boundary(const std::string& text, DABCharset charset, size_t pos);
+    static size_t char_count(const std::string& text, DABCharset charset);
+    size_t dls_seg_len(const std::string& text, DABCharset charset, size_t seg_text_offset);
+    std::vector<size_t> dls_seg_lens(const std::string& text, DABCharset charset);
+    size_t dls_fitting_len(const std::string& text, DABCharset charset);
+    std::vector<size_t> dls_seg_lens_short_xpad(const std::string& text, DABCharset charset);
+    int dls_count(const std::string& text, DABCharset charset);
+    DATA_GROUP* dls_get(const std::string& text, DABCharset charset, const std::vector<size_t>& seg_lens, int seg_index);
+    static void set_dg_toggle(DATA_GROUP& dg, bool toggle);
+    const dl_dgs_cache_entry_t& get_dl_dgs(const std::string& dls_file, const DL_STATE& dl_state);
+    void prepend_dl_dgs(const std::string& dls_file, const DL_STATE& dl_state, bool dl_plus_only);
 
     PADPacketizer* pad_packetizer;
+    const FileWatcher* file_watcher;
     CharsetConverter charset_converter;
     bool dls_toggle;
     DL_STATE dl_state_prev;
 
+    // parsed files and the DGs of their DL states
+    std::map<std::string, dl_file_cache_entry_t> file_cache;
+    std::map<std::string, dl_dgs_cache_entry_t> dgs_cache;
+    size_t dl_dgs_pad_count;
+
+    static std::string join_dl_lines(const std::vector<std::string>& dls_lines, DABCharset charset);
+    bool encode_dl_text(const std::vector<std::string>& dls_lines_utf8, DABCharset charset, std::string& dl_text);
+    void select_dl_charset(const std::vector<std::string>& dls_lines_utf8, DL_STATE& dl_state);
+    void shorten_dl_text(DL_STATE& dl_state);
+    void parseLabel(std::istream& dls_fstream, const DL_PARAMS& dl_params, DL_STATE& dl_state);
     bool parseLabel(const std::string& dls_file, const DL_PARAMS& dl_params, DL_STATE& dl_state);
+    bool parseLabelCached(const std::string& dls_file, const DL_PARAMS& dl_params, DL_STATE& dl_state);
 public:
     static const int APPTYPE_START;
     static const int APPTYPE_CONT;
     static const std::string REQUEST_REREAD_SUFFIX;
-
-    DLSEncoder(PADPacketizer* pad_packetizer) : pad_packetizer(pad_packetizer), dls_toggle(false) {}
-    void encodeLabel(const std::string& dls_file, const char* item_state_file, const DL_PARAMS& dl_params);
+    static const std::string CONTROL_LABEL;
+
+    DLSEncoder(PADPacketizer* pad_packetizer, const FileWatcher* file_watcher = nullptr) :
+        pad_packetizer(pad_packetizer), file_watcher(file_watcher), dls_toggle(false), dl_dgs_pad_count(0) {}
+    void setLabel(const std::string& name, const std::string& content, const DL_PARAMS& dl_params);
+    void preloadLabels(const std::vector<std::string>& dls_files, const char* item_state_file, const DL_PARAMS& dl_params);
+
+    /*! Gets the current label of a DLS file (or of a label set via setLabel()).
+     * A FIFO is read every time, so the label shall be retrieved only once and
+     * then be passed to isLabelNew()/encodeLabel().
+     */
+    bool getLabel(const std::string& dls_file, const char* item_state_file, const DL_PARAMS& dl_params, DL_STATE& dl_state);
+    bool isLabelNew(const DL_STATE& dl_state) const {return dl_state != dl_state_prev;}
+    void encodeLabel(const std::string& dls_file, const DL_STATE& dl_state, const DL_PARAMS& dl_params);
+
+    // number of X-PADs needed to transmit the complete current label
+    size_t getLabelPADCount() const {return dl_dgs_pad_count;}
 };
 
 #endif /* DLS_H_ */
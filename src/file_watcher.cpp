@@ -0,0 +1,210 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file file_watcher.cpp
+    \brief Change notification for input files
+*/
+
+#include "file_watcher.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#if HAVE_SYS_INOTIFY_H
+#  include <sys/inotify.h>
+#endif
+
+
+// --- FileWatcher -----------------------------------------------------------------
+FileWatcher::FileWatcher() : fd(-1) {
+    stop_fds[0] = stop_fds[1] = -1;
+
+#if HAVE_SYS_INOTIFY_H
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd == -1) {
+        perror("ODR-PadEnc Warning: could not initialise file change notification");
+        return;
+    }
+
+    // used to stop the thread
+    if (pipe2(stop_fds, O_CLOEXEC)) {
+        perror("ODR-PadEnc Warning: could not initialise file change notification");
+        close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+    if (thread.joinable()) {
+        if (write(stop_fds[1], "", 1) != 1)
+            perror("ODR-PadEnc Error: could not stop file change notification");
+        thread.join();
+    }
+
+    for (int stop_fd : stop_fds)
+        if (stop_fd != -1)
+            close(stop_fd);
+    if (fd != -1)
+        close(fd);
+}
+
+bool FileWatcher::Watch(const std::string& path) {
+#if HAVE_SYS_INOTIFY_H
+    if (fd == -1)
+        return false;
+
+    // changes of a symlink's target would remain unnoticed
+    struct stat path_stat;
+    if (lstat(path.c_str(), &path_stat) == 0 && S_ISLNK(path_stat.st_mode))
+        return false;
+
+    size_t last_slash = path.find_last_of('/');
+    std::string dir = last_slash == std::string::npos ? "." : path.substr(0, last_slash == 0 ? 1 : last_slash);
+    std::string name = last_slash == std::string::npos ? path : path.substr(last_slash + 1);
+
+    int wd = inotify_add_watch(fd, dir.c_str(),
+            IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+            IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+    if (wd == -1) {
+        perror(("ODR-PadEnc Warning: could not watch dir '" + dir + "'").c_str());
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // the same file under a different path
+    std::map<std::string, std::string>& names = watches[wd];
+    if (names.find(name) != names.end() && names[name] != path)
+        return false;
+
+    names[name] = path;
+    changes.emplace(path, 0);
+    return true;
+#else
+    (void) path;
+    return false;
+#endif
+}
+
+void FileWatcher::Start() {
+    if (fd != -1 && !thread.joinable())
+        thread = std::thread(&FileWatcher::Run, this);
+}
+
+bool FileWatcher::GetChangeCount(const std::string& path, unsigned long& change_count) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::map<std::string, unsigned long>::const_iterator it = changes.find(path);
+    if (it == changes.end())
+        return false;
+
+    change_count = it->second;
+    return true;
+}
+
+void FileWatcher::Run() {
+    // signals shall be handled by the main thread
+    sigset_t sigset;
+    sigfillset(&sigset);
+    pthread_sigmask(SIG_BLOCK, &sigset, nullptr);
+
+    for (;;) {
+        struct pollfd fds[2];
+        fds[0].fd = fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = stop_fds[0];
+        fds[1].events = POLLIN;
+
+        if (poll(fds, 2, -1) == -1) {
+            if (errno == EINTR)
+                continue;
+            perror("ODR-PadEnc Error: file change notification poll failed");
+            break;
+        }
+
+        if (fds[1].revents)
+            break;
+        if (fds[0].revents)
+            ProcessEvents();
+    }
+
+    // changes can no longer be noticed
+    std::lock_guard<std::mutex> lock(mutex);
+    changes.clear();
+}
+
+void FileWatcher::ProcessEvents() {
+#if HAVE_SYS_INOTIFY_H
+    alignas(struct inotify_event) char buf[4096];
+
+    for (;;) {
+        ssize_t len = read(fd, buf, sizeof(buf));
+        if (len <= 0) {
+            if (len == -1 && errno != EAGAIN)
+                perror("ODR-PadEnc Error: reading file change notifications failed");
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (char* ptr = buf; ptr < buf + len;) {
+            const struct inotify_event* event = (const struct inotify_event*) ptr;
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            // events may have been lost
+            if (event->mask & IN_Q_OVERFLOW) {
+                for (auto& change : changes)
+                    change.second++;
+                continue;
+            }
+
+            // the dir itself was removed/moved
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                Unwatch(event->wd);
+                continue;
+            }
+
+            if (event->len == 0)
+                continue;
+
+            std::map<int, std::map<std::string, std::string>>::const_iterator names = watches.find(event->wd);
+            if (names == watches.end())
+                continue;
+            std::map<std::string, std::string>::const_iterator name = names->second.find(event->name);
+            if (name != names->second.end())
+                changes[name->second]++;
+        }
+    }
+#endif
+}
+
+void FileWatcher::Unwatch(int wd) {
+    // the affected files have to be checked by other means
+    std::map<int, std::map<std::string, std::string>>::iterator names = watches.find(wd);
+    if (names == watches.end())
+        return;
+
+    for (const auto& name : names->second)
+        changes.erase(name.second);
+    watches.erase(names);
+
+#if HAVE_SYS_INOTIFY_H
+    inotify_rm_watch(fd, wd);
+#endif
+}
@@ -0,0 +1,71 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file file_watcher.h
+    \brief Change notification for input files
+*/
+
+#ifndef FILE_WATCHER_H_
+#define FILE_WATCHER_H_
+
+#include "common.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+// --- FileWatcher -----------------------------------------------------------------
+/*! Watches files for changes (using inotify on their parent directories),
+ * so that they only have to be checked/read after a change.
+ *
+ * The events are processed by a separate thread; querying the change count
+ * of a file does not involve any syscall.
+ *
+ * If a file cannot be watched (e.g. no inotify support, or a symlink whose
+ * target could change unnoticed), GetChangeCount() returns false and the
+ * file has to be checked as before.
+ */
+class FileWatcher {
+private:
+    int fd;
+    int stop_fds[2];
+    std::thread thread;
+
+    mutable std::mutex mutex;
+    std::map<int, std::map<std::string, std::string>> watches;  // watch descriptor -> file name -> path
+    std::map<std::string, unsigned long> changes;               // path -> change count
+
+    void Run();
+    void ProcessEvents();
+    void Unwatch(int wd);
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool Watch(const std::string& path);
+    void Start();
+
+    // returns false, if the file is not (or no longer) watched
+    bool GetChangeCount(const std::string& path, unsigned long& change_count) const;
+};
+
+#endif /* FILE_WATCHER_H_ */
@@ -0,0 +1,55 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file fuzz.cpp
+    \brief Common code of the fuzz targets (built with --enable-fuzzers)
+*/
+
+#include "fuzz.h"
+
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+
+
+static std::string temp_dir;
+
+static void remove_temp_dir() {
+    DIR* dir = opendir(temp_dir.c_str());
+    if (dir) {
+        while (struct dirent* entry = readdir(dir)) {
+            const std::string name = entry->d_name;
+            if (name != "." && name != "..")
+                unlink((temp_dir + "/" + name).c_str());
+        }
+        closedir(dir);
+    }
+    rmdir(temp_dir.c_str());
+}
+
+const std::string& fuzz_temp_dir() {
+    if (temp_dir.empty()) {
+        char dir_template[] = "/tmp/odr-padenc-fuzz.XXXXXX";
+        if (!mkdtemp(dir_template)) {
+            perror("ODR-PadEnc Error: creating the temporary directory failed");
+            abort();
+        }
+        temp_dir = dir_template;
+        atexit(remove_temp_dir);
+    }
+    return temp_dir;
+}
@@ -0,0 +1,46 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file fuzz.h
+    \brief Common code of the fuzz targets (built with --enable-fuzzers)
+
+    Each fuzz target implements the libFuzzer entry point. If the compiler
+    does not support libFuzzer, fuzz_main.cpp provides a main() that passes
+    the content of the given files to it instead (e.g. to replay a corpus or
+    a crash on a sanitized build).
+*/
+
+#ifndef FUZZ_H_
+#define FUZZ_H_
+
+#include "common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+
+/*! Returns a temporary directory for the files/sockets of a fuzz target.
+ * It is created on the first call, and removed (with its content) on exit.
+ */
+const std::string& fuzz_temp_dir();
+
+#endif /* FUZZ_H_ */
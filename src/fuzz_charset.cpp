@@ -0,0 +1,63 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file fuzz_charset.cpp
+    \brief Fuzz target for the charset conversions (CharsetConverter::convert
+           and the encode/decode functions of all supported charsets)
+*/
+
+#include "fuzz.h"
+#include "charset.h"
+#include "utf8.h"
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const DABCharset charsets[] = {
+        DABCharset::COMPLETE_EBU_LATIN,
+        DABCharset::EBU_LATIN_CY_GR,
+        DABCharset::EBU_LATIN_AR_HE_CY_GR,
+        DABCharset::ISO_LATIN_ALPHABET_2,
+        DABCharset::UCS2_BE,
+        DABCharset::UTF8,
+    };
+
+    CharsetConverter charset_converter;
+    const std::string text((const char*) data, size);
+
+    charset_converter.convert(text);
+    try {
+        charset_converter.convert(text, false);
+    }
+    catch (const utf8::exception&) {
+        // (documented behaviour on invalid UTF-8)
+    }
+    charset_converter.convert_ebu_to_utf8(text);
+
+    for (DABCharset charset : charsets) {
+        std::string encoded;
+        bool lossless = charset_converter.encode(text, charset, encoded);
+
+        // a text converted without loss is restored by decoding
+        if (lossless && charset_converter.decode(encoded, charset) != text) {
+            fprintf(stderr, "ODR-PadEnc Error: text not restored from charset %s\n", CharsetConverter::charset_name(charset));
+            abort();
+        }
+
+        charset_converter.decode(text, charset);
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file fuzz_dl_params.cpp
+    \brief Fuzz target for DLS texts incl. their DL Plus parameters
+           (DLSEncoder::parse_dl_params), from parsing to the PAD
+*/
+
+#include "fuzz.h"
+#include "pad_common.h"
+#include "dls.h"
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static const DABCharset charsets[] = {
+        DABCharset::COMPLETE_EBU_LATIN,
+        DABCharset::ISO_LATIN_ALPHABET_2,
+        DABCharset::UCS2_BE,
+        DABCharset::UTF8,
+    };
+
+    // the first byte selects the DL params and the PAD length
+    if (size < 1)
+        return 0;
+    DL_PARAMS dl_params;
+    dl_params.charset = charsets[data[0] & 0x03];
+    dl_params.output_charset = charsets[(data[0] >> 2) & 0x03];
+    dl_params.auto_output_charset = data[0] & 0x10;
+    dl_params.raw_dls = data[0] & 0x20;
+    const std::string content((const char*) data + 1, size - 1);
+
+    PADPacketizer pad_packetizer(data[0] & 0x40 ? 6 : 58);
+    DLSEncoder dls_encoder(&pad_packetizer);
+
+    DL_STATE dl_state;
+    dls_encoder.setLabel(DLSEncoder::CONTROL_LABEL, content, dl_params);
+    if (dls_encoder.getLabel(DLSEncoder::CONTROL_LABEL, nullptr, dl_params, dl_state))
+        dls_encoder.encodeLabel(DLSEncoder::CONTROL_LABEL, dl_state, dl_params);
+
+    while (pad_packetizer.QueueFilled())
+        pad_packetizer.GetNextPAD(true);
+    return 0;
+}
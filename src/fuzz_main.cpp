@@ -0,0 +1,84 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file fuzz_main.cpp
+    \brief Replays input files to a fuzz target (if built without libFuzzer)
+*/
+
+#include "fuzz.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <vector>
+
+
+static bool replay_file(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        fprintf(stderr, "ODR-PadEnc Error: could not open file '%s'\n", path.c_str());
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    fprintf(stderr, "ODR-PadEnc fuzz input '%s' (%zu bytes)\n", path.c_str(), data.size());
+    LLVMFuzzerTestOneInput(data.data(), data.size());
+    return true;
+}
+
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s FILE/DIR...\n", argv[0]);
+        fprintf(stderr, "Passes the content of each FILE (or of each file in DIR, e.g. a corpus) to the fuzz target.\n");
+        return 1;
+    }
+
+    size_t inputs = 0;
+    for (int i = 1; i < argc; i++) {
+        std::vector<std::string> paths;
+
+        struct stat path_stat;
+        if (stat(argv[i], &path_stat) == 0 && S_ISDIR(path_stat.st_mode)) {
+            DIR* dir = opendir(argv[i]);
+            if (!dir) {
+                perror(("ODR-PadEnc Error: could not open directory '" + std::string(argv[i]) + "'").c_str());
+                return 1;
+            }
+            while (struct dirent* entry = readdir(dir)) {
+                const std::string path = std::string(argv[i]) + "/" + entry->d_name;
+                if (stat(path.c_str(), &path_stat) == 0 && S_ISREG(path_stat.st_mode))
+                    paths.push_back(path);
+            }
+            closedir(dir);
+            std::sort(paths.begin(), paths.end());
+        } else {
+            paths.push_back(argv[i]);
+        }
+
+        for (const std::string& path : paths) {
+            if (!replay_file(path))
+                return 1;
+            inputs++;
+        }
+    }
+
+    fprintf(stderr, "ODR-PadEnc replayed %zu fuzz input(s)\n", inputs);
+    return 0;
+}
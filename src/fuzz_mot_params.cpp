@@ -0,0 +1,47 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file fuzz_mot_params.cpp
+    \brief Fuzz target for the SLS parameter file of a slide
+           (SLSEncoder::process_mot_params_file), from parsing to the PAD
+*/
+
+#include "fuzz.h"
+#include "pad_common.h"
+#include "sls.h"
+
+#include <fstream>
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    // a (raw) slide, whose parameter file has the input as content
+    static const std::string slide_fname = fuzz_temp_dir() + "/slide.jpg";
+    static const std::string params_fname = slide_fname + ".sls_params";
+    static const uint8_t slide[] = {0xFF, 0xD8, 0xFF, 0xD9};
+
+    std::ofstream(slide_fname, std::ios::binary).write((const char*) slide, sizeof(slide));
+    std::ofstream(params_fname, std::ios::binary).write((const char*) data, size);
+
+    // (a new SLSEncoder, as the parsed parameters are cached per file)
+    PADPacketizer pad_packetizer(58);
+    SLSEncoder sls_encoder(&pad_packetizer);
+    sls_encoder.encodeSlide(slide_fname, 0, true, SLSEncoder::MAXSLIDESIZE_SIMPLE, "");
+
+    while (pad_packetizer.QueueFilled())
+        pad_packetizer.GetNextPAD(true);
+    return 0;
+}
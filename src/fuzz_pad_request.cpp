@@ -0,0 +1,73 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file fuzz_pad_request.cpp
+    \brief Fuzz target for the datagrams received from the audio encoder
+           (PadInterface::receive_request)
+*/
+
+#include "fuzz.h"
+#include "pad_interface.h"
+
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    // a request, so that receive_request() does not wait for its timeout
+    static const uint8_t SENTINEL_PADLEN = 58;
+    static const uint8_t sentinel[] = {1, SENTINEL_PADLEN};
+
+    static PadInterface pad_intf;
+    static int sock = -1;
+    static struct sockaddr_un addr;
+    if (sock == -1) {
+        const std::string ident = fuzz_temp_dir() + "/fuzz";
+        pad_intf.open(ident);
+
+        sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (sock == -1) {
+            perror("ODR-PadEnc Error: socket creation failed");
+            abort();
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s.padenc", ident.c_str());
+    }
+
+    // (too large datagrams cannot be sent)
+    if (sendto(sock, data, size, 0, (const struct sockaddr*) &addr, sizeof(addr)) == -1)
+        return 0;
+    if (sendto(sock, sentinel, sizeof(sentinel), 0, (const struct sockaddr*) &addr, sizeof(addr)) == -1) {
+        perror("ODR-PadEnc Error: sending the sentinel failed");
+        abort();
+    }
+
+    // a request is returned, anything else ignored
+    bool request = size >= 2 && data[0] == 1;
+    uint8_t padlen = pad_intf.receive_request();
+    if (padlen != (request ? data[1] : SENTINEL_PADLEN)) {
+        fprintf(stderr, "ODR-PadEnc Error: unexpected PAD length %d received\n", padlen);
+        abort();
+    }
+    if (request && pad_intf.receive_request() != SENTINEL_PADLEN) {
+        fprintf(stderr, "ODR-PadEnc Error: sentinel not received\n");
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,274 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file odr-paddec.cpp
+    \brief Decode PAD data written by ODR-PadEnc (e.g. in offline mode)
+*/
+
+#include "common.h"
+#include "pad_common.h"
+#include "pad_decoder.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+
+
+static void usage(const char* name) {
+    fprintf(stderr, "ODR-PadDec %s - DAB PAD decoder for MOT Slideshow and DLS\n\n"
+                    "Decodes the PAD written by ODR-PadEnc in offline mode (--offline) and prints the\n"
+                    "received labels and MOT objects with their delivery times, and the X-PAD usage.\n\n",
+#if defined(GITVERSION)
+                    GITVERSION
+#else
+                    PACKAGE_VERSION
+#endif
+                    );
+    fprintf(stderr, "Usage: %s [OPTIONS...] FILENAME\n", name);
+    fprintf(stderr, " -p, --padlen=PADLEN       PAD length of the frames in FILENAME (PADLEN + 1 bytes each). Mandatory.\n"
+                    " -f, --frame-duration=DUR  Duration of a frame/AU in milliseconds, to compute delivery times.\n"
+                    "                             Default: 24\n"
+                    " -d, --dir=DIRNAME         Write the received MOT objects to DIRNAME (using their ContentName).\n"
+                    " -c, --check               Check the PAD for format violations (F-PAD, CI lists, continuations,\n"
+                    "                             DG lengths/CRCs, used PAD length), print each one and exit with an\n"
+                    "                             error if there are any. The file must start with the first frame.\n"
+                    " -v, --verbose             Also print repeated labels/MOT objects\n"
+                    " --version                 Print version information and quit\n");
+}
+
+
+static double frames_to_ms(size_t frames, double frame_duration) {
+    return frames * frame_duration;
+}
+
+static void print_violations(size_t frame, const pad_decoder_stats_t& before, const pad_decoder_stats_t& after) {
+    if (after.format_errors > before.format_errors)
+        fprintf(stderr, "ODR-PadDec Error: frame %zu: invalid F-PAD, CI list or DG content\n", frame);
+    if (after.dgs_crc_error > before.dgs_crc_error)
+        fprintf(stderr, "ODR-PadDec Error: frame %zu: DG with wrong CRC\n", frame);
+    if (after.dgs_incomplete > before.dgs_incomplete)
+        fprintf(stderr, "ODR-PadDec Error: frame %zu: DG interrupted by another DG, or of unknown length\n", frame);
+    if (after.dgs_orphaned > before.dgs_orphaned)
+        fprintf(stderr, "ODR-PadDec Error: frame %zu: continuation sub-field w/o a DG being received\n", frame);
+}
+
+static bool write_object(const std::string& dir, const decoded_mot_object_t& object) {
+    std::string name = object.content_name;
+    if (name.empty())
+        name = std::to_string(object.transport_id);
+    std::replace(name.begin(), name.end(), '/', '_');
+
+    std::string path = dir + "/" + name;
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        perror(("ODR-PadDec Error: could not open file '" + path + "'").c_str());
+        return false;
+    }
+    bool success = fwrite(object.body.data(), object.body.size(), 1, f) == 1 || object.body.empty();
+    if (fclose(f))
+        success = false;
+    if (!success)
+        perror(("ODR-PadDec Error: writing file '" + path + "' failed").c_str());
+    return success;
+}
+
+
+int main(int argc, char *argv[]) {
+    if (argc == 2 and strcmp(argv[1], "--version") == 0) {
+        fprintf(stdout, "%s\n",
+#if defined(GITVERSION)
+                GITVERSION
+#else
+                PACKAGE_VERSION
+#endif
+               );
+        return 0;
+    }
+
+    int padlen = 0;
+    double frame_duration = 24;
+    std::string object_dir;
+    bool check = false;
+
+    const struct option longopts[] = {
+        {"padlen",          required_argument,  0, 'p'},
+        {"frame-duration",  required_argument,  0, 'f'},
+        {"dir",             required_argument,  0, 'd'},
+        {"check",           no_argument,        0, 'c'},
+        {"verbose",         no_argument,        0, 'v'},
+        {"help",            no_argument,        0, 'h'},
+        {0,0,0,0},
+    };
+
+    int ch;
+    while((ch = getopt_long(argc, argv, "hcvp:f:d:", longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'p':
+                padlen = atoi(optarg);
+                break;
+            case 'f':
+                frame_duration = atof(optarg);
+                break;
+            case 'd':
+                object_dir = optarg;
+                break;
+            case 'c':
+                check = true;
+                break;
+            case 'v':
+                verbose++;
+                break;
+            case '?':
+            case 'h':
+                usage(argv[0]);
+                return 0;
+        }
+    }
+
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (padlen < 0 || !PADPacketizer::CheckPADLen(padlen)) {
+        fprintf(stderr, "ODR-PadDec Error: PAD length %d invalid: Possible values: %s\n",
+                padlen, PADPacketizer::ALLOWED_PADLEN.c_str());
+        return 1;
+    }
+    const char* filename = argv[optind];
+
+    FILE* input = fopen(filename, "rb");
+    if (!input) {
+        perror(("ODR-PadDec Error: could not open file '" + std::string(filename) + "'").c_str());
+        return 1;
+    }
+
+    PADDecoder decoder;
+    std::vector<uint8_t> frame(padlen + 1);
+    size_t invalid_used_len = 0;
+    size_t check_errors = 0;
+    int result = 0;
+
+    decoded_label_t label;
+    decoded_label_t prev_label;
+    decoded_dl_plus_t dl_plus;
+    decoded_mot_object_t object;
+
+    size_t label_count = 0;
+    double label_latency_sum = 0;
+    double label_latency_max = 0;
+    size_t object_count = 0;
+    double object_latency_sum = 0;
+    double object_latency_max = 0;
+
+    while (fread(frame.data(), frame.size(), 1, input) == 1) {
+        // the last byte is the used PAD length
+        if (frame[padlen] > padlen)
+            invalid_used_len++;
+
+        pad_decoder_stats_t stats_before = decoder.GetStats();
+        decoder.ProcessPAD(frame.data(), padlen);
+
+        if (check) {
+            size_t frame_nr = decoder.GetFrameCount() - 1;
+            print_violations(frame_nr, stats_before, decoder.GetStats());
+
+            // the used PAD length must match the parsed PAD, and the rest (in front of it) be zero padding
+            size_t used_len = decoder.GetUsedLen();
+            bool parsed = decoder.GetStats().format_errors == stats_before.format_errors;
+            if (parsed && frame[padlen] != used_len) {
+                fprintf(stderr, "ODR-PadDec Error: frame %zu: used PAD length %d instead of %zu\n", frame_nr, frame[padlen], used_len);
+                check_errors++;
+            }
+            if (parsed && std::any_of(frame.begin(), frame.begin() + (padlen - used_len), [](uint8_t b) {return b != 0x00;})) {
+                fprintf(stderr, "ODR-PadDec Error: frame %zu: non-zero padding\n", frame_nr);
+                check_errors++;
+            }
+        }
+
+        while (decoder.GetLabel(label)) {
+            double latency = frames_to_ms(label.last_frame - label.first_frame + 1, frame_duration);
+            label_count++;
+            label_latency_sum += latency;
+            label_latency_max = std::max(label_latency_max, latency);
+
+            if (verbose || label_count == 1 || label.text != prev_label.text || label.toggle != prev_label.toggle || label.charset != prev_label.charset) {
+                printf("frame %zu (%.3f s): label '%s' (charset %d, toggle %d) within %.0f ms\n",
+                        label.last_frame, frames_to_ms(label.last_frame, frame_duration) / 1000,
+                        label.text_utf8.c_str(), (int) label.charset, label.toggle, latency);
+            }
+            prev_label = label;
+        }
+
+        while (decoder.GetDLPlusCommand(dl_plus)) {
+            if (!verbose)
+                continue;
+            printf("frame %zu (%.3f s): DL Plus (item toggle %d, item running %d):",
+                    dl_plus.frame, frames_to_ms(dl_plus.frame, frame_duration) / 1000,
+                    dl_plus.item_toggle, dl_plus.item_running);
+            for (const decoded_dl_plus_t::tag_t& tag : dl_plus.tags)
+                printf(" %d/%d/%d", tag.content_type, tag.start_marker, tag.length_marker);
+            printf("\n");
+        }
+
+        while (decoder.GetMOTObject(object)) {
+            double latency = frames_to_ms(object.last_frame - object.first_frame + 1, frame_duration);
+            object_count++;
+            object_latency_sum += latency;
+            object_latency_max = std::max(object_latency_max, latency);
+
+            printf("frame %zu (%.3f s): MOT object %d '%s' (%zu Bytes, type %d/%d%s) within %.0f ms\n",
+                    object.last_frame, frames_to_ms(object.last_frame, frame_duration) / 1000,
+                    object.transport_id, object.content_name.c_str(), object.body.size(),
+                    object.content_type, object.content_subtype, object.from_directory ? ", MOT directory" : "",
+                    latency);
+
+            if (!object_dir.empty() && !write_object(object_dir, object))
+                result = 1;
+        }
+    }
+
+    if (ferror(input)) {
+        perror("ODR-PadDec Error: reading input file failed");
+        result = 1;
+    } else if (!feof(input) || ftell(input) % frame.size()) {
+        fprintf(stderr, "ODR-PadDec Warning: the file ends with an incomplete frame\n");
+    }
+    fclose(input);
+
+    if (invalid_used_len && !check)
+        fprintf(stderr, "ODR-PadDec Warning: %zu frames with a used PAD length greater than %d\n", invalid_used_len, padlen);
+
+    decoder.GetStats().Print(stdout);
+    if (label_count)
+        printf("ODR-PadDec label delivery: avg %.0f ms, max %.0f ms\n", label_latency_sum / label_count, label_latency_max);
+    if (object_count)
+        printf("ODR-PadDec MOT object delivery: avg %.0f ms, max %.0f ms\n", object_latency_sum / object_count, object_latency_max);
+
+    if (check) {
+        size_t violations = decoder.GetStats().Violations() + check_errors;
+        if (violations) {
+            fprintf(stderr, "ODR-PadDec Error: %zu format violations found\n", violations);
+            result = 1;
+        } else {
+            printf("ODR-PadDec check passed: no format violations\n");
+        }
+    }
+
+    return result;
+}
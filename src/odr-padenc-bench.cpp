@@ -0,0 +1,291 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file odr-padenc-bench.cpp
+    \brief Microbenchmarks for the hot paths of ODR-PadEnc (built by "make bench")
+*/
+
+#include "common.h"
+#include "crc.h"
+#include "charset.h"
+#include "pad_common.h"
+#include "dls.h"
+#include "sls.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+
+using std::chrono::steady_clock;
+
+
+static double min_time = 0.5;   // s
+static std::string filter;
+
+// prevents the compiler from optimising away the benchmarked code
+static volatile uint64_t sink;
+
+
+/*! Runs func(iterations) with increasing iterations, until it takes at least
+ * the min. time, and prints the time per iteration (and the throughput).
+ */
+template<typename F>
+static void run_benchmark(const std::string& name, size_t bytes_per_iteration, F func) {
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+        return;
+
+    size_t iterations = 1;
+    double elapsed;
+    for (;;) {
+        steady_clock::time_point start = steady_clock::now();
+        func(iterations);
+        elapsed = std::chrono::duration<double>(steady_clock::now() - start).count();
+
+        if (elapsed >= min_time)
+            break;
+
+        // aim slightly above the min. time
+        size_t next = elapsed > 0 ? (size_t) (iterations * min_time * 1.2 / elapsed) : iterations * 100;
+        iterations = std::max(iterations * 2, std::min(next, iterations * 100));
+    }
+
+    printf("%-48s %12.1f ns %12zu", name.c_str(), elapsed * 1e9 / iterations, iterations);
+    if (bytes_per_iteration)
+        printf(" %10.1f MB/s", bytes_per_iteration * iterations / elapsed / 1e6);
+    printf("\n");
+    fflush(stdout);
+}
+
+
+static uint8_vector_t random_data(size_t len) {
+    uint8_vector_t data(len);
+    for (uint8_t& b : data)
+        b = rand() & 0xFF;
+    return data;
+}
+
+
+// --- benchmarks -----------------------------------------------------------------
+static void bench_crc() {
+    uint8_vector_t data = random_data(1024);
+
+    run_benchmark("odr::crc16/1024", data.size(), [&](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++)
+            sink += odr::crc16(0xFFFF, data.data(), data.size());
+    });
+}
+
+static void bench_dg_write() {
+    DATA_GROUP dg(1024, 12, 13);
+    uint8_t subfield[48];
+
+    run_benchmark("DATA_GROUP::Write/1024 in 48 byte sub-fields", dg.data.size(), [&](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+            dg.written = 0;
+            int cont_apptype;
+            while (dg.Available() > 0)
+                sink += dg.Write(subfield, sizeof(subfield), &cont_apptype);
+        }
+    });
+}
+
+static void bench_get_next_pad() {
+    // a mix of a MOT DG (with DGLI) and the DGs of a label
+    std::vector<DATA_GROUP> dgs;
+    DATA_GROUP mot_dg(1024, SLSEncoder::APPTYPE_MOT_START, SLSEncoder::APPTYPE_MOT_CONT);
+    DATA_GROUP* dgli = PADPacketizer::CreateDataGroupLengthIndicator(mot_dg.data.size());
+    dgs.push_back(*dgli);
+    delete dgli;
+    dgs.push_back(mot_dg);
+    for (int i = 0; i < 4; i++)
+        dgs.push_back(DATA_GROUP(20, DLSEncoder::APPTYPE_START, DLSEncoder::APPTYPE_CONT));
+
+    for (size_t padlen = 1; padlen <= 196; padlen++) {
+        if (!PADPacketizer::CheckPADLen(padlen))
+            continue;
+
+        PADPacketizer packetizer(padlen);
+        run_benchmark("PADPacketizer::GetNextPAD/" + std::to_string(padlen), padlen, [&](size_t iterations) {
+            for (size_t i = 0; i < iterations; i++) {
+                if (!packetizer.QueueFilled()) {
+                    for (const DATA_GROUP& dg : dgs)
+                        packetizer.AddDG(new DATA_GROUP(dg), false);
+                }
+                sink += packetizer.GetNextPAD(true)[0];
+            }
+        });
+    }
+}
+
+static void bench_dls() {
+    PADPacketizer packetizer(58);
+    DLSEncoder dls_encoder(&packetizer);
+    DL_PARAMS dl_params;
+
+    const std::string texts[] = {
+        "Now playing: Queen - Bohemian Rhapsody (A Night at the Opera)",
+        "Now playing: Björk - Jóga (Homogenic)\n"
+        "##### parameters { #####\n"
+        "DL_PLUS=1\n"
+        "DL_PLUS_TAG=4 13 4\n"
+        "DL_PLUS_TAG=1 20 3\n"
+        "##### parameters } #####\n",
+    };
+
+    DL_STATE dl_state;
+
+    // the label is already encoded (e.g. the repetition of the current label)
+    dls_encoder.setLabel(DLSEncoder::CONTROL_LABEL, texts[0], dl_params);
+    run_benchmark("DLSEncoder::encodeLabel/unchanged", 0, [&](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+            dls_encoder.getLabel(DLSEncoder::CONTROL_LABEL, nullptr, dl_params, dl_state);
+            dls_encoder.encodeLabel(DLSEncoder::CONTROL_LABEL, dl_state, dl_params);
+            sink += packetizer.RemoveUnstartedDGs(DLSEncoder::APPTYPE_START);
+        }
+    });
+
+    // a new label is parsed and encoded
+    run_benchmark("DLSEncoder::setLabel+encodeLabel/new", 0, [&](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+            dls_encoder.setLabel(DLSEncoder::CONTROL_LABEL, texts[i % 2], dl_params);
+            dls_encoder.getLabel(DLSEncoder::CONTROL_LABEL, nullptr, dl_params, dl_state);
+            dls_encoder.encodeLabel(DLSEncoder::CONTROL_LABEL, dl_state, dl_params);
+            sink += packetizer.RemoveUnstartedDGs(DLSEncoder::APPTYPE_START);
+        }
+    });
+}
+
+static void bench_charset() {
+    CharsetConverter charset_converter;
+    const std::string text_utf8 = "Now playing: Björk - Jóga (Homogenic) / Motörhead - Ace of Spades / Édith Piaf - Non, je ne regrette rien";
+    const std::string text_ebu = charset_converter.convert(text_utf8);
+
+    run_benchmark("CharsetConverter::convert/" + std::to_string(text_utf8.size()), text_utf8.size(), [&](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++)
+            sink += charset_converter.convert(text_utf8).size();
+    });
+
+    run_benchmark("CharsetConverter::decode/" + std::to_string(text_ebu.size()), text_ebu.size(), [&](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++)
+            sink += charset_converter.decode(text_ebu, DABCharset::COMPLETE_EBU_LATIN).size();
+    });
+}
+
+static void bench_sls() {
+    uint8_vector_t segment = random_data(SLSEncoder::MAXSEGLEN);
+
+    MSCDG msc;
+    memset(&msc, 0, sizeof(msc));
+    msc.crcflag = 1;
+    msc.segflag = 1;
+    msc.accflag = 1;
+    msc.dgtype = 4;
+    msc.tidflag = 1;
+    msc.lenid = 2;
+    msc.segdata = segment.data();
+    msc.seglen = segment.size();
+
+    run_benchmark("SLSEncoder::packMscDG/" + std::to_string(segment.size()), segment.size(), [&](size_t iterations) {
+        for (size_t i = 0; i < iterations; i++) {
+            DATA_GROUP* dg = SLSEncoder::packMscDG(&msc);
+            sink += dg->data.back();
+            delete dg;
+        }
+    });
+
+    // a raw slide of the max. size; the DGs are discarded
+    uint8_vector_t slide = random_data(SLSEncoder::MAXSLIDESIZE_SIMPLE);
+    {
+        PADPacketizer packetizer(58);
+        SLSEncoder sls_encoder(&packetizer);
+        run_benchmark("SLSEncoder::encodeSlideData/" + std::to_string(slide.size()), slide.size(), [&](size_t iterations) {
+            for (size_t i = 0; i < iterations; i++) {
+                sink += sls_encoder.encodeSlideData(slide, 0, true, SLSEncoder::MAXSLIDESIZE_SIMPLE, "");
+                sink += packetizer.RemoveUnstartedDGs(SLSEncoder::APPTYPE_MOT_START, true);
+            }
+        });
+    }
+
+    // the same slide, incl. its packetizing into PADs
+    for (size_t padlen : {6, 58, 196}) {
+        PADPacketizer packetizer(padlen);
+        SLSEncoder sls_encoder(&packetizer);
+        run_benchmark("slide to PADs/" + std::to_string(slide.size()) + "/" + std::to_string(padlen), slide.size(), [&](size_t iterations) {
+            for (size_t i = 0; i < iterations; i++) {
+                sink += sls_encoder.encodeSlideData(slide, 0, true, SLSEncoder::MAXSLIDESIZE_SIMPLE, "");
+                while (packetizer.QueueFilled())
+                    sink += packetizer.GetNextPAD(true)[0];
+            }
+        });
+    }
+}
+
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s [OPTIONS...]\n", name);
+    fprintf(stderr, " -f, --filter=TEXT         Only run the benchmarks whose name contains TEXT\n"
+                    " -t, --min-time=DUR        Run each benchmark for at least DUR seconds\n"
+                    "                             Default: %g\n",
+                    min_time);
+}
+
+
+int main(int argc, char *argv[]) {
+    const struct option longopts[] = {
+        {"filter",          required_argument,  0, 'f'},
+        {"min-time",        required_argument,  0, 't'},
+        {"help",            no_argument,        0, 'h'},
+        {0,0,0,0},
+    };
+
+    int ch;
+    while((ch = getopt_long(argc, argv, "hf:t:", longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'f':
+                filter = optarg;
+                break;
+            case 't':
+                min_time = atof(optarg);
+                break;
+            case '?':
+            case 'h':
+                usage(argv[0]);
+                return 0;
+        }
+    }
+
+#if HAVE_MAGICKWAND
+    MagickWandGenesis();
+#endif
+
+    printf("%-48s %15s %12s %15s\n", "Benchmark", "Time", "Iterations", "Throughput");
+    printf("%s\n", std::string(48 + 1 + 15 + 1 + 12 + 1 + 15, '-').c_str());
+
+    bench_crc();
+    bench_dg_write();
+    bench_get_next_pad();
+    bench_dls();
+    bench_charset();
+    bench_sls();
+
+#if HAVE_MAGICKWAND
+    MagickWandTerminus();
+#endif
+
+    return 0;
+}
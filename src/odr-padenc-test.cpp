@@ -0,0 +1,309 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file odr-padenc-test.cpp
+    \brief Tests of the PADPacketizer (and the DLSEncoder) against the
+           PADDecoder (built and run by "make check")
+*/
+
+#include "common.h"
+#include "pad_common.h"
+#include "pad_decoder.h"
+#include "dls.h"
+#include "sls.h"
+
+#include <cstdlib>
+#include <deque>
+#include <random>
+
+
+static std::mt19937 rng;
+static unsigned int seed = 1;
+static size_t padlen;           // of the current test
+static size_t failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed (PAD length %zu, seed %u): %s\n", __FILE__, __LINE__, padlen, seed, #cond); \
+            failures++; \
+            return; \
+        } \
+    } while (0)
+
+
+static size_t random_size(size_t min, size_t max) {
+    return std::uniform_int_distribution<size_t>(min, max)(rng);
+}
+
+
+// --- DGs -----------------------------------------------------------------
+/*! Creates a DL segment with random text (and a valid prefix).
+ */
+static DATA_GROUP* create_dl_segment() {
+    size_t len = random_size(1, 16);
+    bool first_seg = random_size(0, 1);
+    bool last_seg = random_size(0, 1);
+
+    DATA_GROUP* dg = new DATA_GROUP(2 + len, DLSEncoder::APPTYPE_START, DLSEncoder::APPTYPE_CONT);
+    uint8_vector_t &data = dg->data;
+    data[0] = (random_size(0, 1) << 7) | (first_seg << 6) | (last_seg << 5) | (len - 1);
+    data[1] = (first_seg ? (size_t) DABCharset::COMPLETE_EBU_LATIN : random_size(1, 7)) << 4;
+    for (size_t i = 0; i < len; i++)
+        data[2 + i] = random_size(0x20, 0x7E);
+    dg->AppendCRC();
+    return dg;
+}
+
+/*! Creates a DL "remove label" command, i.e. the smallest possible DG.
+ */
+static DATA_GROUP* create_dl_remove_label() {
+    DATA_GROUP* dg = new DATA_GROUP(2, DLSEncoder::APPTYPE_START, DLSEncoder::APPTYPE_CONT);
+    dg->data[0] = (random_size(0, 1) << 7) | 0x10 | DLS_CMD_REMOVE_LABEL;
+    dg->data[1] = 0x00;
+    dg->AppendCRC();
+    return dg;
+}
+
+/*! Creates a (not last) MOT body segment with random content.
+ */
+static DATA_GROUP* create_mot_body_segment() {
+    size_t len = random_size(1, 300);
+    size_t seg_index = random_size(0, 0x7FFF);
+    size_t tid = random_size(0, 0xFFFF);
+
+    DATA_GROUP* dg = new DATA_GROUP(9 + len, SLSEncoder::APPTYPE_MOT_START, SLSEncoder::APPTYPE_MOT_CONT);
+    uint8_vector_t &data = dg->data;
+    data[0] = 0x74;     // CRC, segment field, user access field; MOT body
+    data[1] = 0x00;
+    data[2] = seg_index >> 8;
+    data[3] = seg_index & 0xFF;
+    data[4] = 0x12;     // TransportId (2 bytes)
+    data[5] = tid >> 8;
+    data[6] = tid & 0xFF;
+    data[7] = len >> 8;
+    data[8] = len & 0xFF;
+    for (size_t i = 0; i < len; i++)
+        data[9 + i] = random_size(0x00, 0xFF);
+    dg->AppendCRC();
+    return dg;
+}
+
+
+// --- Checks -----------------------------------------------------------------
+/*! Checks the format of a PAD, as sent to the audio encoder.
+ */
+static void check_pad(const std::vector<uint8_t>& pad, const PADDecoder& decoder) {
+    // PAD length + used PAD length byte
+    CHECK(pad.size() == padlen + 1);
+    CHECK(pad[padlen] == decoder.GetUsedLen());
+
+    // the unused X-PAD bytes are padding
+    for (size_t i = 0; i < padlen - decoder.GetUsedLen(); i++)
+        CHECK(pad[i] == 0x00);
+}
+
+/*! Checks the prefix of a DL DG (EN 300 401 v2.1.1, ch. 7.4.5.2).
+ */
+static void check_dl_prefix(const decoded_dg_t& dg) {
+    CHECK(dg.data.size() >= 4);
+
+    bool first_seg = dg.data[0] & 0x40;
+    if (dg.data[0] & 0x10)
+        return;     // command
+
+    // segment: the rfa bits are zero, and so the segment number is within 0..7 (and 0 only for the first segment)
+    CHECK(dg.data.size() == 2 + (dg.data[0] & 0x0F) + 1u + 2);
+    CHECK((dg.data[1] & (first_seg ? 0x0F : 0x8F)) == 0);
+    CHECK(first_seg || (dg.data[1] >> 4) != 0);
+}
+
+
+// --- Tests -----------------------------------------------------------------
+/*! Packetizes random DGs (interleaved with PADs w/o X-PAD) and checks that
+ * the decoder reassembles exactly the same DGs, in the same order.
+ */
+static void test_random_dgs(size_t dg_count) {
+    PADPacketizer packetizer(padlen);
+    PADDecoder decoder;
+    decoder.KeepDGs(true);
+
+    std::deque<uint8_vector_t> expected_dgs;
+    std::deque<int> expected_apptypes;
+    size_t expected_bytes = 0;
+    size_t added = 0;
+
+    while (added < dg_count || packetizer.QueueFilled()) {
+        // add some DGs (the queue stays rather short, as in the encoder)
+        if (added < dg_count && (!packetizer.QueueFilled() || random_size(0, 3) == 0)) {
+            for (size_t i = random_size(1, 4); i > 0 && added < dg_count; i--, added++) {
+                DATA_GROUP* dg;
+                switch (random_size(0, 4)) {
+                case 0:
+                    dg = create_dl_remove_label();
+                    break;
+                case 1:
+                case 2:
+                    dg = create_dl_segment();
+                    break;
+                default:
+                    // the DG is preceded by a DGLI
+                    dg = create_mot_body_segment();
+                    DATA_GROUP* dgli = PADPacketizer::CreateDataGroupLengthIndicator(dg->data.size());
+                    expected_dgs.push_back(dgli->data);
+                    expected_apptypes.push_back(dgli->apptype_start);
+                    expected_bytes += dgli->data.size();
+                    packetizer.AddDG(dgli, false);
+                    break;
+                }
+                expected_dgs.push_back(dg->data);
+                expected_apptypes.push_back(dg->apptype_start);
+                expected_bytes += dg->data.size();
+                packetizer.AddDG(dg, false);
+            }
+        }
+
+        // sometimes a PAD w/o X-PAD is requested (which interrupts a continuation w/o CI)
+        std::vector<uint8_t> pad = packetizer.GetNextPAD(random_size(0, 7) != 0);
+        decoder.ProcessPAD(pad.data(), padlen);
+        size_t failures_before = failures;
+        check_pad(pad, decoder);
+        if (failures != failures_before)
+            return;
+
+        // each DG is received exactly once, unchanged and in order
+        decoded_dg_t dg;
+        while (decoder.GetDG(dg)) {
+            CHECK(!expected_dgs.empty());
+            CHECK(dg.apptype == expected_apptypes.front());
+            CHECK(dg.data == expected_dgs.front());
+            expected_dgs.pop_front();
+            expected_apptypes.pop_front();
+        }
+    }
+
+    CHECK(expected_dgs.empty());
+    CHECK(decoder.GetStats().Violations() == 0);
+
+    // no DG byte was output more than once
+    CHECK(packetizer.GetStats().dg_bytes + packetizer.GetStats().dglis * 4 == expected_bytes);
+    CHECK(decoder.GetStats().dg_bytes == expected_bytes);
+}
+
+/*! Encodes labels by the DLSEncoder and checks the DL DGs and the decoded
+ * labels (which may be shortened).
+ */
+static void test_labels() {
+    // (each with the charset chosen for it automatically)
+    const std::pair<const char*, DABCharset> texts[] = {
+        {"Now playing: Queen - Bohemian Rhapsody (A Night at the Opera)", DABCharset::COMPLETE_EBU_LATIN},
+        {"Now playing: Björk - Jóga (Homogenic) / Motörhead - Ace of Spades / Édith Piaf - Non, je ne regrette rien / "
+            "Sigur Rós - Hoppípolla", DABCharset::COMPLETE_EBU_LATIN},
+        {"日本語日本語日本語日本語日本語日本語日本語日本語日本語日本語日本語日本語日本語日本語", DABCharset::UCS2_BE},
+        {"Ελληνικά Ελληνικά Ελληνικά Ελληνικά Ελληνικά Ελληνικά Ελληνικά Ελληνικά Ελληνικά Ελληνικά", DABCharset::EBU_LATIN_CY_GR},
+        {"Сейчас в эфире: Кино - Группа крови (1988)", DABCharset::EBU_LATIN_CY_GR},
+        {"ΡΑΔΙΟΦΩΝΟ ΑΘΗΝΑ 98,4", DABCharset::EBU_LATIN_CY_GR},
+        {"רדיו תל אביב 102FM", DABCharset::EBU_LATIN_AR_HE_CY_GR},
+        {"Now playing: Björk - Jóga\n"
+            "##### parameters { #####\n"
+            "DL_PLUS=1\n"
+            "DL_PLUS_TAG=4 13 5\n"
+            "DL_PLUS_TAG=1 21 4\n"
+            "##### parameters } #####\n", DABCharset::COMPLETE_EBU_LATIN},
+    };
+    // (output charsets that can represent all texts)
+    const std::pair<DABCharset, bool> output_charsets[] = {
+        {DABCharset::COMPLETE_EBU_LATIN, true},     // auto
+        {DABCharset::UCS2_BE, false},
+        {DABCharset::UTF8, false},
+    };
+
+    PADPacketizer packetizer(padlen);
+    DLSEncoder dls_encoder(&packetizer);
+    PADDecoder decoder;
+    decoder.KeepDGs(true);
+
+    for (const std::pair<const char*, DABCharset>& text_charset : texts) {
+        const char* text = text_charset.first;
+        for (const std::pair<DABCharset, bool>& output_charset : output_charsets) {
+            DL_PARAMS dl_params;
+            dl_params.output_charset = output_charset.first;
+            dl_params.auto_output_charset = output_charset.second;
+
+            DL_STATE dl_state;
+            dls_encoder.setLabel(DLSEncoder::CONTROL_LABEL, text, dl_params);
+            CHECK(dls_encoder.getLabel(DLSEncoder::CONTROL_LABEL, nullptr, dl_params, dl_state));
+            dls_encoder.encodeLabel(DLSEncoder::CONTROL_LABEL, dl_state, dl_params);
+
+            while (packetizer.QueueFilled()) {
+                std::vector<uint8_t> pad = packetizer.GetNextPAD(true);
+                decoder.ProcessPAD(pad.data(), padlen);
+                size_t failures_before = failures;
+                check_pad(pad, decoder);
+                if (failures != failures_before)
+                    return;
+            }
+
+            // at most 8 segments, with a valid prefix each
+            size_t segs = 0;
+            decoded_dg_t dg;
+            while (decoder.GetDG(dg)) {
+                if (dg.apptype != DLSEncoder::APPTYPE_START || (dg.data[0] & 0x10))
+                    continue;
+                size_t failures_before = failures;
+                check_dl_prefix(dg);
+                if (failures != failures_before)
+                    return;
+                segs++;
+            }
+            CHECK(segs >= 1 && segs <= 8);
+
+            // the (possibly shortened) label is received completely
+            decoded_label_t label;
+            CHECK(decoder.GetLabel(label));
+            CHECK(!label.text_utf8.empty());
+            CHECK(std::string(text).compare(0, label.text_utf8.size(), label.text_utf8) == 0);
+            CHECK(label.charset == (output_charset.second ? text_charset.second : output_charset.first));
+            CHECK(!decoder.GetLabel(label));
+        }
+    }
+
+    CHECK(decoder.GetStats().Violations() == 0);
+}
+
+
+int main(int argc, char *argv[]) {
+    // a seed can be specified, to reproduce a failure
+    if (argc > 1)
+        seed = strtoul(argv[1], nullptr, 10);
+    rng.seed(seed);
+
+    for (padlen = 6; padlen <= 196; padlen++) {
+        if (!PADPacketizer::CheckPADLen(padlen))
+            continue;
+
+        test_random_dgs(300);
+        test_labels();
+    }
+
+    if (failures) {
+        fprintf(stderr, "ODR-PadEnc tests: %zu check(s) failed\n", failures);
+        return 1;
+    }
+    fprintf(stderr, "ODR-PadEnc tests: all checks passed (seed %u)\n", seed);
+    return 0;
+}
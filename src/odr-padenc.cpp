@@ -28,6 +28,7 @@
 */
 
 #include "odr-padenc.h"
+#include <climits>
 #include <memory>
 
 std::atomic<bool> do_exit;
@@ -52,8 +53,18 @@ static void header() {
                     );
 }
 
+static bool parse_charset(const char* arg, DABCharset& charset) {
+    // only the IDs defined in TS 101 756
+    int id;
+    if (!parse_int(arg, id) || id < 0 || id > 15 || !CharsetConverter::charset_name((DABCharset) id))
+        return false;
+    charset = (DABCharset) id;
+    return true;
+}
+
 static void usage(const char* name) {
     PadEncoderOptions options_default;
+    OfflineOptions offline_default;
     fprintf(stderr, "Usage: %s [OPTIONS...]\n", name);
     fprintf(stderr, " -d, --dir=DIRNAME         Directory to read images from.\n"
                     " -e, --erase               Erase slides from DIRNAME once they have\n"
@@ -66,16 +77,46 @@ static void usage(const char* name) {
                     "                             Otherwise, /tmp/ is prepended for backward compatibility\n"
                     " --dump-current-slide=F1   Write the slide currently being transmitted to the file F1\n"
                     " --dump-completed-slide=F2 Once the slide is transmitted, move the file from F1 to F2\n"
+                    " --slide-cache=DIR         Share processed slides with other ODR-PadEnc instances using the\n"
+                    "                             same slides, by storing them in the directory DIR.\n"
+                    " --mot-directory           Use MOT directory mode instead of MOT header mode, so that\n"
+                    "                             receivers can cache the slides of the carousel.\n"
+                    " --mot-segment-size=SIZE   Split slides into MOT segments of at most SIZE bytes (max. %zu).\n"
+                    "                             Smaller segments are less likely lost on bad reception, larger\n"
+                    "                             ones need less overhead. The resulting efficiency is printed.\n"
+                    "                             Default: %zu\n"
+                    " --mot-repetitions=COUNT   Transmit each slide COUNT more times (max. %d), to improve\n"
+                    "                             reception on bad conditions at the cost of throughput.\n"
+                    "                             Default: %d\n"
+                    " --mot-interleave=COUNT    Transmit up to COUNT slides at once, interleaved, instead of one\n"
+                    "                             after another (e.g. for category slideshows with many small\n"
+                    "                             slides). Requires --mot-directory. -s then applies to each\n"
+                    "                             group of slides; as the slides of a group are completed at\n"
+                    "                             about the same time, receivers without a category slideshow\n"
+                    "                             may only show the last one of them.\n"
+                    "                             Default: %d\n"
+                    " --control=PATH            Receive DLS texts and slides from other programs using a UNIX\n"
+                    "                             datagram socket at PATH (see src/control_interface.h). A DLS\n"
+                    "                             text received is used until the next DLS file change (-l) or\n"
+                    "                             re-read request. A priority slide aborts the other slides in\n"
+                    "                             transmission, which are then transmitted again afterwards.\n"
                     " -t, --dls=FILENAME        FIFO or file to read DLS text from.\n"
                     "                             If specified more than once, use next file after -l delay.\n"
                     " -c, --charset=ID          ID of the character set encoding used for DLS text input.\n"
                     "                             ID =  0: Complete EBU Latin based repertoire\n"
+                    "                             ID =  1: EBU Latin based common core, Cyrillic, Greek\n"
+                    "                             ID =  2: EBU Latin based core, Arabic, Hebrew, Cyrillic, Greek\n"
+                    "                             ID =  3: ISO Latin Alphabet No 2\n"
                     "                             ID =  6: ISO/IEC 10646 using UCS-2 BE\n"
                     "                             ID = 15: ISO/IEC 10646 using UTF-8\n"
                     "                             Default: 15\n"
+                    " --dls-output-charset=ID   ID of the character set encoding used to transmit DLS texts\n"
+                    "                             (same IDs as for -c). If ID is 'auto', each text is encoded\n"
+                    "                             in the charset needing the least segments/bytes, e.g.\n"
+                    "                             Cyrillic or Greek texts in charset 1 (one byte per character).\n"
+                    "                             Default: 0\n"
                     " -r, --remove-dls          Always insert a DLS Remove Label command when replacing a DLS text.\n"
-                    " -C, --raw-dls             Do not convert DLS texts to Complete EBU Latin based repertoire\n"
-                    "                             character set encoding.\n"
+                    " -C, --raw-dls             Do not convert DLS texts to the output character set encoding.\n"
                     " -I, --item-state=FILENAME FIFO or file to read the DL Plus Item Toggle/Running bits from (instead of the current DLS file).\n"
                     " -m, --max-slide-size=SIZE Recompress slide if above the specified maximum size in bytes.\n"
                     "                             Default: %zu (Simple Profile)\n"
@@ -90,16 +131,40 @@ static void usage(const char* name) {
                     "                             Default: %d\n"
                     " -L, --label-ins=DUR       Insert label every DUR milliseconds\n"
                     "                             Default: %d\n"
+                    " --label-target=DUR        Instead of -L, repeat the label so that receivers get it completely\n"
+                    "                             within DUR milliseconds, considering the time needed to transmit it\n"
+                    "                             at the current PAD length and X-PAD interval. If slides are used,\n"
+                    "                             labels are limited to %d%% of the X-PAD bandwidth.\n"
                     " -X, --xpad-interval=COUNT Output X-PAD every COUNT frames/AUs (otherwise: only F-PAD)\n"
                     "                             Default: %d\n"
+                    " --offline=FILENAME        Do not communicate with an audio encoder, but simulate its PAD\n"
+                    "                             requests as fast as possible and write the PAD to FILENAME\n"
+                    "                             (PADLEN + 1 bytes per frame, as sent to the audio encoder).\n"
+                    "                             Useful for benchmarks and for comparing the output of versions.\n"
+                    " --offline-padlen=PADLEN   PAD length to simulate.\n"
+                    "                             Default: %d\n"
+                    " --offline-frames=COUNT    Number of frames/AUs to simulate.\n"
+                    "                             Default: %zu\n"
+                    " --offline-frame-duration=DUR Simulated duration of a frame/AU in milliseconds\n"
+                    "                             (DAB: 24; DAB+: 20 or 40, depending on sample rate and SBR).\n"
+                    "                             Default: %g\n"
                     "\n"
                     "The PAD length is configured on the audio encoder and communicated over the socket to ODR-PadEnc\n"
                     "Allowed PAD lengths are: %s\n",
                     options_default.slide_interval,
+                    SLSEncoder::MAXSEGLEN_LIMIT,
+                    options_default.mot_segment_size,
+                    SLSEncoder::MAXREPETITIONS,
+                    options_default.mot_repetitions,
+                    options_default.mot_interleave,
                     options_default.max_slide_size,
                     options_default.label_interval,
                     options_default.label_insertion,
+                    (int) (PadEncoder::LABEL_MAX_DUTY_CYCLE_SLS * 100),
                     options_default.xpad_interval,
+                    offline_default.padlen,
+                    offline_default.frames,
+                    offline_default.frame_duration,
                     PADPacketizer::ALLOWED_PADLEN.c_str()
            );
 }
@@ -116,6 +181,53 @@ static std::string list_dls_files(std::vector<std::string> dls_files) {
 }
 
 
+static int encode_offline(const PadEncoderOptions& options, const OfflineOptions& offline, ControlInterface* control_intf) {
+    FILE* output = fopen(offline.output_file.c_str(), "wb");
+    if (!output) {
+        perror(("ODR-PadEnc Error: could not open offline output file '" + offline.output_file + "'").c_str());
+        return 1;
+    }
+
+    fprintf(stderr, "ODR-PadEnc simulating %zu requests for PAD length %d, every %g ms\n",
+            offline.frames, offline.padlen, offline.frame_duration);
+
+    int result = 0;
+    size_t frame = 0;
+    {
+        PadEncoder pad_encoder(options);
+
+        // the simulated requests start right after initialisation, just like real ones
+        const steady_clock::time_point start = steady_clock::now();
+        std::vector<uint8_t> pad;
+
+        for (; frame < offline.frames && !do_exit; frame++) {
+            steady_clock::time_point pad_timeline = start + std::chrono::duration_cast<steady_clock::duration>(
+                    std::chrono::duration<double, std::milli>(frame * offline.frame_duration));
+
+            result = pad_encoder.Encode(pad_timeline, control_intf, pad);
+            if (result > 0)
+                break;
+
+            if (fwrite(pad.data(), pad.size(), 1, output) != 1) {
+                perror("ODR-PadEnc Error: writing offline output file failed");
+                result = 1;
+                break;
+            }
+        }
+
+        double elapsed = std::chrono::duration<double>(steady_clock::now() - start).count();
+        fprintf(stderr, "ODR-PadEnc encoded %zu frames (%.1f s of audio) in %.3f s: %.0f frames/s\n",
+                frame, frame * offline.frame_duration / 1000, elapsed, elapsed > 0 ? frame / elapsed : 0.0);
+    }
+
+    if (fclose(output)) {
+        perror("ODR-PadEnc Error: closing offline output file failed");
+        result = 1;
+    }
+    return result;
+}
+
+
 int main(int argc, char *argv[]) {
     // Version handling is done very early to ensure nothing else but the version gets printed out
     if (argc == 2 and strcmp(argv[1], "--version") == 0) {
@@ -133,6 +245,7 @@ int main(int argc, char *argv[]) {
 
     // get/check options
     PadEncoderOptions options;
+    OfflineOptions offline;
 
     const struct option longopts[] = {
         {"charset",         required_argument,  0, 'c'},
@@ -153,6 +266,18 @@ int main(int argc, char *argv[]) {
         {"verbose",         no_argument,        0, 'v'},
         {"dump-current-slide",   required_argument, 0, 1},
         {"dump-completed-slide", required_argument, 0, 2},
+        {"slide-cache",          required_argument, 0, 3},
+        {"dls-output-charset",   required_argument, 0, 4},
+        {"label-target",         required_argument, 0, 5},
+        {"control",              required_argument, 0, 6},
+        {"mot-directory",        no_argument,       0, 7},
+        {"mot-segment-size",     required_argument, 0, 8},
+        {"mot-repetitions",      required_argument, 0, 9},
+        {"mot-interleave",       required_argument, 0, 10},
+        {"offline",              required_argument, 0, 11},
+        {"offline-padlen",       required_argument, 0, 12},
+        {"offline-frames",       required_argument, 0, 13},
+        {"offline-frame-duration", required_argument, 0, 14},
         {0,0,0,0},
     };
 
@@ -160,7 +285,11 @@ int main(int argc, char *argv[]) {
     while((ch = getopt_long(argc, argv, "eChRrc:d:o:s:t:I:l:L:X:vm:", longopts, NULL)) != -1) {
         switch (ch) {
             case 'c':
-                options.dl_params.charset = (DABCharset) atoi(optarg);
+                if (!parse_charset(optarg, options.dl_params.charset)) {
+                    fprintf(stderr, "ODR-PadEnc Error: Invalid charset '%s'!\n", optarg);
+                    usage(argv[0]);
+                    return 1;
+                }
                 break;
             case 'C':
                 options.dl_params.raw_dls = true;
@@ -210,6 +339,52 @@ int main(int argc, char *argv[]) {
             case 2: // dump-completed-slide
                 options.completed_slide_dump_name = optarg;
                 break;
+            case 3: // slide-cache
+                options.slide_cache_dir = optarg;
+                break;
+            case 4: // dls-output-charset
+                if (strcmp(optarg, "auto") == 0)
+                    options.dl_params.auto_output_charset = true;
+                else if (!parse_charset(optarg, options.dl_params.output_charset)) {
+                    fprintf(stderr, "ODR-PadEnc Error: Invalid DLS output charset '%s'!\n", optarg);
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 5: // label-target
+                if (!parse_int(optarg, options.label_target) || options.label_target <= 0) {
+                    fprintf(stderr, "ODR-PadEnc Error: Invalid label target '%s'!\n", optarg);
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 6: // control
+                options.control_socket = optarg;
+                break;
+            case 7: // mot-directory
+                options.mot_directory = true;
+                break;
+            case 8: // mot-segment-size
+                options.mot_segment_size = atoi(optarg);
+                break;
+            case 9: // mot-repetitions
+                options.mot_repetitions = atoi(optarg);
+                break;
+            case 10: // mot-interleave
+                options.mot_interleave = atoi(optarg);
+                break;
+            case 11: // offline
+                offline.output_file = optarg;
+                break;
+            case 12: // offline-padlen
+                offline.padlen = atoi(optarg);
+                break;
+            case 13: // offline-frames
+                offline.frames = strtoul(optarg, nullptr, 10);
+                break;
+            case 14: // offline-frame-duration
+                offline.frame_duration = atof(optarg);
+                break;
             case '?':
             case 'h':
                 usage(argv[0]);
@@ -223,65 +398,93 @@ int main(int argc, char *argv[]) {
         return 2;
     }
 
+    if (options.mot_segment_size < 1 || options.mot_segment_size > SLSEncoder::MAXSEGLEN_LIMIT) {
+        fprintf(stderr, "ODR-PadEnc Error: MOT segment size %zu out of range 1..%zu\n",
+                options.mot_segment_size, SLSEncoder::MAXSEGLEN_LIMIT);
+        return 2;
+    }
+
+    if (options.mot_repetitions < 0 || options.mot_repetitions > SLSEncoder::MAXREPETITIONS) {
+        fprintf(stderr, "ODR-PadEnc Error: MOT repetitions %d out of range 0..%d\n",
+                options.mot_repetitions, SLSEncoder::MAXREPETITIONS);
+        return 2;
+    }
+
+    if (options.mot_interleave < 1) {
+        fprintf(stderr, "ODR-PadEnc Error: MOT interleave count %d must be at least 1\n", options.mot_interleave);
+        return 2;
+    }
+
+    if (options.mot_interleave > 1 && !options.mot_directory) {
+        fprintf(stderr, "ODR-PadEnc Error: MOT interleave requires MOT directory mode (--mot-directory)\n");
+        return 2;
+    }
+
+    if (offline.Enabled()) {
+        if (offline.padlen < 0 || !PADPacketizer::CheckPADLen(offline.padlen)) {
+            fprintf(stderr, "ODR-PadEnc Error: PAD length %d invalid: Possible values: %s\n",
+                    offline.padlen, PADPacketizer::ALLOWED_PADLEN.c_str());
+            return 2;
+        }
+        if (!(offline.frame_duration > 0)) {
+            fprintf(stderr, "ODR-PadEnc Error: The simulated frame duration must be greater than 0!\n");
+            return 2;
+        }
+    }
+
+    const std::string& output = offline.Enabled() ? offline.output_file : options.socket_ident;
     if (options.sls_dir && not options.dls_files.empty()) {
         fprintf(stderr, "ODR-PadEnc encoding Slideshow from '%s' and DLS from %s to '%s'\n",
-                options.sls_dir, list_dls_files(options.dls_files).c_str(), options.socket_ident.c_str());
+                options.sls_dir, list_dls_files(options.dls_files).c_str(), output.c_str());
     }
     else if (options.sls_dir) {
         fprintf(stderr, "ODR-PadEnc encoding Slideshow from '%s' to '%s'. No DLS.\n",
-                options.sls_dir, options.socket_ident.c_str());
+                options.sls_dir, output.c_str());
     }
     else if (not options.dls_files.empty()) {
         fprintf(stderr, "ODR-PadEnc encoding DLS from %s to '%s'. No Slideshow.\n",
-                list_dls_files(options.dls_files).c_str(), options.socket_ident.c_str());
+                list_dls_files(options.dls_files).c_str(), output.c_str());
     }
-    else {
+    else if (options.control_socket.empty()) {
         fprintf(stderr, "ODR-PadEnc Error: Neither DLS nor Slideshow to encode !\n");
         usage(argv[0]);
         return 1;
     }
 
-    const char* user_charset;
-    switch (options.dl_params.charset) {
-        case DABCharset::COMPLETE_EBU_LATIN:
-            user_charset = "Complete EBU Latin";
-            break;
-        case DABCharset::EBU_LATIN_CY_GR:
-            user_charset = "EBU Latin core, Cyrillic, Greek";
-            break;
-        case DABCharset::EBU_LATIN_AR_HE_CY_GR:
-            user_charset = "EBU Latin core, Arabic, Hebrew, Cyrillic, Greek";
-            break;
-        case DABCharset::ISO_LATIN_ALPHABET_2:
-            user_charset = "ISO Latin Alphabet 2";
-            break;
-        case DABCharset::UCS2_BE:
-            user_charset = "UCS-2 BE";
-            break;
-        case DABCharset::UTF8:
-            user_charset = "UTF-8";
-            break;
-        default:
-            fprintf(stderr, "ODR-PadEnc Error: Invalid charset!\n");
-            usage(argv[0]);
-            return 1;
+    if (options.sls_dir && options.mot_directory)
+        fprintf(stderr, "ODR-PadEnc using MOT directory mode\n");
+
+    if (not options.control_socket.empty())
+        fprintf(stderr, "ODR-PadEnc accepting DLS texts and slides via control socket '%s'\n", options.control_socket.c_str());
+
+    const char* user_charset = CharsetConverter::charset_name(options.dl_params.charset);
+    if (!user_charset) {
+        fprintf(stderr, "ODR-PadEnc Error: Invalid charset!\n");
+        usage(argv[0]);
+        return 1;
     }
 
     fprintf(stderr, "ODR-PadEnc using charset %s (%d)\n",
            user_charset, (int) options.dl_params.charset);
 
     if (not options.dl_params.raw_dls) {
-        switch (options.dl_params.charset) {
-        case DABCharset::COMPLETE_EBU_LATIN:
-            // no conversion needed
-            break;
-        case DABCharset::UTF8:
-            fprintf(stderr, "ODR-PadEnc converting DLS texts to Complete EBU Latin\n");
-            break;
-        default:
-            fprintf(stderr, "ODR-PadEnc Error: DLS conversion to EBU is currently only supported for UTF-8 input!\n");
+        const DABCharset output_charset = options.dl_params.output_charset;
+        if (not CharsetConverter::is_supported(output_charset)) {
+            fprintf(stderr, "ODR-PadEnc Error: DLS conversion to charset %d is not supported!\n", (int) output_charset);
+            return 1;
+        }
+        if (not CharsetConverter::is_supported(options.dl_params.charset)) {
+            fprintf(stderr, "ODR-PadEnc Error: DLS conversion from charset %s is not supported!\n", user_charset);
             return 1;
         }
+
+        if (options.dl_params.auto_output_charset) {
+            fprintf(stderr, "ODR-PadEnc converting DLS texts to the most compact charset\n");
+        }
+        else if (options.dl_params.charset != output_charset) {
+            fprintf(stderr, "ODR-PadEnc converting DLS texts to %s\n",
+                    CharsetConverter::charset_name(output_charset));
+        }
     }
 
     if (options.item_state_file)
@@ -318,14 +521,23 @@ int main(int argc, char *argv[]) {
     int result = 0;
 
     PadInterface intf;
+    ControlInterface control_intf;
     try {
-        intf.open(options.socket_ident);
+        if (not options.control_socket.empty())
+            control_intf.open(options.control_socket);
+
+        if (offline.Enabled()) {
+            options.padlen = offline.padlen;
+            result = encode_offline(options, offline, options.control_socket.empty() ? nullptr : &control_intf);
+        }
+        else
+            intf.open(options.socket_ident);
 
         uint8_t previous_padlen = 0;
 
         std::shared_ptr<PadEncoder> pad_encoder;
 
-        while (!do_exit) {
+        while (!do_exit && !offline.Enabled()) {
             options.padlen = intf.receive_request();
 
             if (options.padlen > 0) {
@@ -340,14 +552,22 @@ int main(int argc, char *argv[]) {
                     }
                     else {
                         fprintf(stderr, "ODR-PadEnc Reinitialise PAD length to %d\n", options.padlen);
-                        pad_encoder = std::make_shared<PadEncoder>(options);
+                        std::shared_ptr<PadEncoder> new_pad_encoder = std::make_shared<PadEncoder>(options);
+
+                        // keep a label received via control socket
+                        std::string control_label;
+                        if (pad_encoder && pad_encoder->GetControlLabel(control_label))
+                            new_pad_encoder->SetControlLabel(control_label);
+                        pad_encoder = new_pad_encoder;
                     }
                 }
 
-                result = pad_encoder->Encode(intf);
+                std::vector<uint8_t> pad;
+                result = pad_encoder->Encode(steady_clock::now(), options.control_socket.empty() ? nullptr : &control_intf, pad);
                 if (result > 0) {
                     break;
                 }
+                intf.send_pad_data(pad.data(), pad.size());
             }
         }
     }
@@ -364,13 +584,22 @@ int main(int argc, char *argv[]) {
 
 
 // --- PadEncoder -----------------------------------------------------------------
+const double PadEncoder::LABEL_MAX_DUTY_CYCLE_SLS = 0.5;
+const int PadEncoder::SLIDE_TAG_CAROUSEL = 1;   // slides from the control socket get the following tags
+
 PadEncoder::PadEncoder(PadEncoderOptions options) :
         options(options),
         pad_packetizer(PADPacketizer(options.padlen)),
-        dls_encoder(DLSEncoder(&pad_packetizer)),
-        sls_encoder(SLSEncoder(&pad_packetizer)),
+        dls_encoder(DLSEncoder(&pad_packetizer, &file_watcher)),
+        sls_encoder(SLSEncoder(&pad_packetizer, options.slide_cache_dir, options.mot_directory, options.mot_segment_size, options.mot_repetitions)),
         slides_success(false),
-        curr_dls_file(0)
+        resume_carousel(false),
+        next_slide_tag(SLIDE_TAG_CAROUSEL + 1),
+        label_warn_shown(false),
+        curr_dls_file(0),
+        control_label(false),
+        frame_duration(0),
+        label_pad_count_reported(0)
 {
     // PAD related timelines
     next_slide = next_label = next_label_insertion = steady_clock::now();
@@ -380,10 +609,49 @@ PadEncoder::PadEncoder(PadEncoderOptions options) :
         curr_dls_file = -1;
     }
 
+    // watch input/request files, so that they only have to be checked after a change
+    if (options.SLSEnabled())
+        file_watcher.Watch(std::string(options.sls_dir) + "/" + SLSEncoder::REQUEST_REREAD_FILENAME);
+    for (const std::string& dls_file : options.dls_files) {
+        file_watcher.Watch(dls_file);
+        file_watcher.Watch(dls_file + DLSEncoder::REQUEST_REREAD_SUFFIX);
+    }
+    if (options.item_state_file)
+        file_watcher.Watch(options.item_state_file);
+    file_watcher.Start();
+
+    // the efficiency depends on the PAD length
+    if (options.SLSEnabled())
+        sls_encoder.printSegmentationOverhead(options.max_slide_size);
+
+    // prepare the labels of all DLS files, so that rotating between them is cheap
+    if (options.DLSEnabled())
+        dls_encoder.preloadLabels(options.dls_files, options.item_state_file, options.dl_params);
+
     xpad_interval_counter = 0;
 }
 
 
+PadEncoder::~PadEncoder() {
+    if (verbose)
+        pad_packetizer.GetStats().Print();
+}
+
+
+bool PadEncoder::FileMayHaveChanged(const std::string& path) {
+    // unwatched files have to be checked every time
+    unsigned long change_count;
+    if (!file_watcher.GetChangeCount(path, change_count))
+        return true;
+
+    auto it = file_change_counts.find(path);
+    if (it != file_change_counts.end() && it->second == change_count)
+        return false;
+
+    file_change_counts[path] = change_count;
+    return true;
+}
+
 int PadEncoder::CheckRereadFile(const std::string& type, const std::string& path) {
     struct stat path_stat;
     if (stat(path.c_str(), &path_stat)) {
@@ -402,7 +670,7 @@ int PadEncoder::CheckRereadFile(const std::string& type, const std::string& path
     }
 }
 
-int PadEncoder::EncodeSlide() {
+int PadEncoder::EncodeSlide(steady_clock::time_point pad_timeline) {
     // skip insertion, if previous one not yet finished
     if (pad_packetizer.QueueContainsDG(SLSEncoder::APPTYPE_MOT_START)) {
         fprintf(stderr, "ODR-PadEnc Warning: skipping slide insertion, as previous one still in transmission!\n");
@@ -410,7 +678,8 @@ int PadEncoder::EncodeSlide() {
     }
 
     // check for slides dir re-read request
-    int reread = CheckRereadFile("slides dir", std::string(options.sls_dir) + "/" + SLSEncoder::REQUEST_REREAD_FILENAME);
+    std::string reread_file = std::string(options.sls_dir) + "/" + SLSEncoder::REQUEST_REREAD_FILENAME;
+    int reread = FileMayHaveChanged(reread_file) ? CheckRereadFile("slides dir", reread_file) : 0;
     switch (reread) {
     case 1:     // re-read requested
         slides.Clear();
@@ -419,13 +688,26 @@ int PadEncoder::EncodeSlide() {
         return 1;
     }
 
-    // usually invoked once
+    // several slides may be transmitted at once
+    carousel_slides.clear();
+    sls_encoder.setDGTag(SLIDE_TAG_CAROUSEL);
+    sls_encoder.beginInterleave();
+
+    // usually invoked once per slide
     for (;;) {
-        // try to read slides dir (if present)
+        // try to read slides dir (if present); not for further slides, to not add the same slide twice
         if (slides.Empty()) {
-            if (!slides.InitFromDir(options.sls_dir))
+            if (!carousel_slides.empty())
+                break;
+            if (!slides.InitFromDir(options.sls_dir)) {
+                sls_encoder.endInterleave();
                 return 1;
+            }
             slides_success = false;
+
+            // the MOT directory shall only describe the current slides
+            if (options.mot_directory)
+                sls_encoder.retainDirectoryObjects(slides.GetFidxs());
         }
 
         // if slides available, encode the first one
@@ -434,10 +716,9 @@ int PadEncoder::EncodeSlide() {
 
             if (sls_encoder.encodeSlide(slide.filepath, slide.fidx, options.raw_slides, options.max_slide_size, options.current_slide_dump_name)) {
                 slides_success = true;
-                if (options.erase_after_tx) {
-                    if (unlink(slide.filepath.c_str()))
-                        perror(("ODR-PadEnc Error: erasing file '" + slide.filepath +"' failed").c_str());
-                }
+                carousel_slides.push_back(slide);
+                if (carousel_slides.size() < (size_t) options.mot_interleave)
+                    continue;
             } else {
                 /* skip to next slide, except this is the last slide and so far
                  * no slide worked, to prevent an infinite loop and because
@@ -453,12 +734,25 @@ int PadEncoder::EncodeSlide() {
         break;
     }
 
+    sls_encoder.endInterleave();
+    if (!carousel_slides.empty())
+        carousel_slides_inserted = pad_timeline;
     return 0;
 }
 
 int PadEncoder::EncodeLabel() {
-    // delay insertion, if previous one not yet finished
-    if (pad_packetizer.QueueContainsDG(DLSEncoder::APPTYPE_START)) {
+    // a label received via control socket replaces the DLS file(s)
+    if (!control_label && options.dls_files.empty())
+        return 0;
+    const std::string& label = control_label ? DLSEncoder::CONTROL_LABEL : options.dls_files[curr_dls_file];
+
+    // the label is retrieved only once, as a FIFO can be read only once
+    DL_STATE dl_state;
+    bool label_read = dls_encoder.getLabel(label, options.item_state_file, options.dl_params, dl_state);
+
+    // delay insertion, if previous one not yet finished (unless replaced by a new label)
+    if (pad_packetizer.QueueContainsDG(DLSEncoder::APPTYPE_START) &&
+            !(label_read && dls_encoder.isLabelNew(dl_state))) {
         if(!label_warn_shown) {
             fprintf(stderr, "ODR-PadEnc Warning: there is a label already in transmission, delaying until the previous one ends.\n");
             label_warn_shown = true;
@@ -470,17 +764,171 @@ int PadEncoder::EncodeLabel() {
             fprintf(stderr, "ODR-PadEnc Previous label ended transmission, sending the new one.\n");
             label_warn_shown = false;
         }
-        dls_encoder.encodeLabel(options.dls_files[curr_dls_file], options.item_state_file, options.dl_params);
+        if (label_read)
+            dls_encoder.encodeLabel(label, dl_state, options.dl_params);
         return 1;
     }
 }
 
 
-int PadEncoder::Encode(PadInterface& intf) {
-    steady_clock::time_point pad_timeline = std::chrono::steady_clock::now();
+int PadEncoder::GetLabelInsertionInterval() {
+    /*! Repeat the label so that receivers get it completely within the target
+     * time: a receiver tuning in just after an insertion started has to wait
+     * for the next one and its transmission, i.e. interval + airtime. The label
+     * is not inserted again before it has been transmitted completely, and if
+     * slides are used, the share of the X-PAD bandwidth used by labels is
+     * limited.
+     */
+    size_t label_pad_count = dls_encoder.getLabelPADCount();
+    int airtime = label_pad_count * options.xpad_interval * frame_duration;
+    bool report = label_pad_count != label_pad_count_reported;
+    label_pad_count_reported = label_pad_count;
+
+    int interval = options.label_target - airtime;
+    if (interval < airtime) {
+        if (report)
+            fprintf(stderr, "ODR-PadEnc Warning: label target of %d ms cannot be met, as the label needs %d ms to be transmitted; "
+                    "receivers get it within %d ms\n", options.label_target, airtime, 2 * airtime);
+        interval = airtime;
+    }
+    if (options.SLSEnabled())
+        interval = std::max(interval, (int) (airtime / LABEL_MAX_DUTY_CYCLE_SLS));
+
+    if (verbose && report) {
+        fprintf(stderr, "ODR-PadEnc label needs %zu X-PADs (%d ms); inserting it every %d ms (duty cycle: %d%%, worst case reception: %d ms)\n",
+                label_pad_count, airtime, interval, interval > 0 ? airtime * 100 / interval : 100, interval + airtime);
+    }
+
+    return interval;
+}
+
+
+void PadEncoder::AbortSlidesForPrioritySlide() {
+    /*! Aborts the carousel slide(s) and the other slides from the control
+     * socket in transmission (at a DG boundary), so that the priority slide is
+     * transmitted next. They are transmitted again after the priority slide.
+     * Priority slides already queued are transmitted first.
+     */
+    size_t cancelled = pad_packetizer.RemoveUnstartedDGs(SLSEncoder::APPTYPE_MOT_START, true, SLIDE_TAG_CAROUSEL);
+    if (cancelled && !carousel_slides.empty()) {
+        for (auto it = carousel_slides.rbegin(); it != carousel_slides.rend(); it++)
+            slides.PutBackSlide(*it);
+        carousel_slides.clear();
+        resume_carousel = true;
+    }
+
+    for (control_slide_t& slide : control_slides) {
+        if (slide.priority || !slide.tag)
+            continue;
+        size_t slide_cancelled = pad_packetizer.RemoveUnstartedDGs(SLSEncoder::APPTYPE_MOT_START, true, slide.tag);
+        if (slide_cancelled) {
+            slide.tag = 0;
+            cancelled += slide_cancelled;
+        }
+    }
+
+    if (cancelled)
+        fprintf(stderr, "ODR-PadEnc priority slide aborts slide in transmission (%zu DGs cancelled)\n", cancelled);
+}
+
+bool PadEncoder::PrioritySlideQueued() const {
+    for (const control_slide_t& slide : control_slides)
+        if (slide.priority)
+            return true;
+    return false;
+}
+
+void PadEncoder::EncodeControlSlides() {
+    // other slides wait until all priority slides have been transmitted
+    bool priority_slide_queued = PrioritySlideQueued();
+
+    for (auto it = control_slides.begin(); it != control_slides.end();) {
+        if (it->tag || (!it->priority && priority_slide_queued)) {
+            it++;
+            continue;
+        }
+
+        int tag = next_slide_tag;
+        next_slide_tag = next_slide_tag < INT_MAX ? next_slide_tag + 1 : SLIDE_TAG_CAROUSEL + 1;
+
+        sls_encoder.setDGTag(tag);
+        if (!sls_encoder.encodeSlideData(it->data, slides.GetFidx(it->data), options.raw_slides, options.max_slide_size, options.current_slide_dump_name)) {
+            fprintf(stderr, "ODR-PadEnc Error: cannot encode %sslide from control socket; skipping\n", it->priority ? "priority " : "");
+            it = control_slides.erase(it);
+            continue;
+        }
+        it->tag = tag;
+        it++;
+    }
+}
+
+
+void PadEncoder::SetControlLabel(const std::string& content) {
+    dls_encoder.setLabel(DLSEncoder::CONTROL_LABEL, content, options.dl_params);
+    control_label = true;
+    control_label_content = content;
+}
+
+bool PadEncoder::GetControlLabel(std::string& content) const {
+    if (control_label)
+        content = control_label_content;
+    return control_label;
+}
+
+
+void PadEncoder::HandleControlMessages(ControlInterface& control_intf, steady_clock::time_point pad_timeline) {
+    control_message_t message;
+    while (control_intf.receive_message(message)) {
+        switch (message.type) {
+        case CONTROL_MESSAGE_DLS:
+            if (verbose)
+                fprintf(stderr, "ODR-PadEnc received DLS text via control socket\n");
+            SetControlLabel(std::string(message.data.begin(), message.data.end()));
+
+            // enforce label insertion
+            next_label_insertion = pad_timeline;
+            break;
+        case CONTROL_MESSAGE_SLIDE:
+            if (message.data.empty()) {
+                fprintf(stderr, "ODR-PadEnc Warning: ignoring empty slide from control socket\n");
+                break;
+            }
+            if (verbose)
+                fprintf(stderr, "ODR-PadEnc received slide via control socket (%zu bytes)\n", message.data.size());
+            control_slides.push_back(control_slide_t{message.data, false, pad_timeline, 0});
+            break;
+        case CONTROL_MESSAGE_PRIORITY_SLIDE:
+            if (message.data.empty()) {
+                fprintf(stderr, "ODR-PadEnc Warning: ignoring empty slide from control socket\n");
+                break;
+            }
+            if (verbose)
+                fprintf(stderr, "ODR-PadEnc received priority slide via control socket (%zu bytes)\n", message.data.size());
+            AbortSlidesForPrioritySlide();
+            control_slides.push_back(control_slide_t{message.data, true, pad_timeline, 0});
+            break;
+        default:
+            fprintf(stderr, "ODR-PadEnc Warning: ignoring control message of unknown type %d\n", message.type);
+        }
+    }
+}
+
+
+int PadEncoder::Encode(steady_clock::time_point pad_timeline, ControlInterface* control_intf, std::vector<uint8_t>& pad) {
+    // measure the interval between PAD requests (= frame duration)
+    if (prev_pad != steady_clock::time_point()) {
+        double interval = std::chrono::duration<double, std::milli>(pad_timeline - prev_pad).count();
+        frame_duration = frame_duration > 0 ? 0.9 * frame_duration + 0.1 * interval : interval;
+    }
+    prev_pad = pad_timeline;
 
     int result = 0;
 
+    // handle DLS texts/slides from other programs
+    if (control_intf)
+        HandleControlMessages(*control_intf, pad_timeline);
+    EncodeControlSlides();
+
     // handle SLS
     if (options.SLSEnabled()) {
 
@@ -498,16 +946,43 @@ int PadEncoder::Encode(PadInterface& intf) {
             }
         }
 
-        if (options.slide_interval > 0) {
+        // the carousel slide has been transmitted
+        if (!pad_packetizer.QueueContainsDG(SLSEncoder::APPTYPE_MOT_START, SLIDE_TAG_CAROUSEL)) {
+            if (verbose && !carousel_slides.empty())
+                fprintf(stderr, "ODR-PadEnc %zu carousel slide(s) transmitted within %lld ms\n",
+                        carousel_slides.size(),
+                        (long long) std::chrono::duration_cast<std::chrono::milliseconds>(pad_timeline - carousel_slides_inserted).count());
+
+            // erase the slides only now, as an aborted slide is encoded again from its file
+            if (options.erase_after_tx) {
+                for (const slide_metadata_t& slide : carousel_slides) {
+                    if (unlink(slide.filepath.c_str()))
+                        perror(("ODR-PadEnc Error: erasing file '" + slide.filepath +"' failed").c_str());
+                }
+            }
+            carousel_slides.clear();
+        }
+
+        if (PrioritySlideQueued()) {
+            // the carousel pauses until the priority slide(s) have been transmitted
+        } else if (resume_carousel) {
+            // transmit the aborted slide right away (after aborted slides from the control socket)
+            if (!pad_packetizer.QueueContainsDG(SLSEncoder::APPTYPE_MOT_START)) {
+                resume_carousel = false;
+                result = EncodeSlide(pad_timeline);
+                if (options.slide_interval > 0)
+                    next_slide = pad_timeline + std::chrono::seconds(options.slide_interval);
+            }
+        } else if (options.slide_interval > 0) {
             // encode slides regularly
             if (pad_timeline >= next_slide) {
-                result = EncodeSlide();
+                result = EncodeSlide(pad_timeline);
                 next_slide += std::chrono::seconds(options.slide_interval);
             }
         } else {
             // encode slide as soon as previous slide has been transmitted
             if (!pad_packetizer.QueueContainsDG(SLSEncoder::APPTYPE_MOT_START))
-                result = EncodeSlide();
+                result = EncodeSlide(pad_timeline);
         }
     }
     if (result)
@@ -517,11 +992,13 @@ int PadEncoder::Encode(PadInterface& intf) {
     if (options.DLSEnabled()) {
         // check for DLS re-read request
         for (size_t i = 0; i < options.dls_files.size(); i++) {
-            int reread = CheckRereadFile("DLS file '" + options.dls_files[i] + "'", options.dls_files[i] + DLSEncoder::REQUEST_REREAD_SUFFIX);
+            std::string reread_file = options.dls_files[i] + DLSEncoder::REQUEST_REREAD_SUFFIX;
+            int reread = FileMayHaveChanged(reread_file) ? CheckRereadFile("DLS file '" + options.dls_files[i] + "'", reread_file) : 0;
             switch (reread) {
             case 1:     // re-read requested
                 // switch to desired DLS file
                 curr_dls_file = i;
+                control_label = false;
                 next_label = pad_timeline + std::chrono::seconds(options.label_interval);
 
                 // enforce label insertion
@@ -535,6 +1012,7 @@ int PadEncoder::Encode(PadInterface& intf) {
         if (options.dls_files.size() > 1 && pad_timeline >= next_label) {
             // switch to next DLS file
             curr_dls_file = (curr_dls_file + 1) % options.dls_files.size();
+            control_label = false;
             next_label += std::chrono::seconds(options.label_interval);
 
             // enforce label insertion
@@ -546,15 +1024,28 @@ int PadEncoder::Encode(PadInterface& intf) {
             int label_encode_result = 0;
             label_encode_result = EncodeLabel();
             if(label_encode_result > 0) {
-                next_label_insertion += std::chrono::milliseconds(options.label_insertion);
+                if (options.label_target > 0 && frame_duration > 0)
+                    next_label_insertion = pad_timeline + std::chrono::milliseconds(GetLabelInsertionInterval());
+                else
+                    next_label_insertion += std::chrono::milliseconds(options.label_insertion);
             }
         }
     }
 
     // flush one PAD (considering X-PAD output interval)
-    auto pad = pad_packetizer.GetNextPAD(xpad_interval_counter == 0);
+    pad = pad_packetizer.GetNextPAD(xpad_interval_counter == 0);
 
-    intf.send_pad_data(pad.data(), pad.size());
+    // forget the transmitted slides from the control socket (and report the time-to-air of a priority slide)
+    for (auto it = control_slides.begin(); it != control_slides.end();) {
+        if (!it->tag || pad_packetizer.QueueContainsDG(SLSEncoder::APPTYPE_MOT_START, it->tag)) {
+            it++;
+            continue;
+        }
+        if (it->priority)
+            fprintf(stderr, "ODR-PadEnc priority slide transmitted within %lld ms\n",
+                    (long long) std::chrono::duration_cast<std::chrono::milliseconds>(pad_timeline - it->received).count());
+        it = control_slides.erase(it);
+    }
 
     // update X-PAD output interval counter
     xpad_interval_counter = (xpad_interval_counter + 1) % options.xpad_interval;
@@ -30,6 +30,7 @@
 #include "common.h"
 
 #include <atomic>
+#include <deque>
 #include <stdlib.h>
 #include <signal.h>
 #include <string>
@@ -42,6 +43,8 @@
 #include <unistd.h>
 
 #include "pad_interface.h"
+#include "control_interface.h"
+#include "file_watcher.h"
 #include "pad_common.h"
 #include "dls.h"
 #include "sls.h"
@@ -56,9 +59,14 @@ struct PadEncoderOptions {
     int slide_interval = 10;
     int label_interval = 12;    // uniform PAD encoder only
     int label_insertion = 1200; // uniform PAD encoder only
+    int label_target = 0;       // uniform PAD encoder only; 0 = fixed label insertion
     int xpad_interval = 1;      // uniform PAD encoder only
     size_t max_slide_size = SLSEncoder::MAXSLIDESIZE_SIMPLE;
     bool raw_slides = false;
+    bool mot_directory = false;
+    size_t mot_segment_size = SLSEncoder::MAXSEGLEN;
+    int mot_repetitions = 0;
+    int mot_interleave = 1;
     DL_PARAMS dl_params;
 
     const char *sls_dir = nullptr;
@@ -67,36 +75,97 @@ struct PadEncoderOptions {
     const char *item_state_file = nullptr;
     std::string current_slide_dump_name;
     std::string completed_slide_dump_name;
+    std::string slide_cache_dir;
+    std::string control_socket;
 
-    bool DLSEnabled() const { return !dls_files.empty(); }
+    bool DLSEnabled() const { return !dls_files.empty() || !control_socket.empty(); }
     bool SLSEnabled() const { return sls_dir; }
 };
 
 
+// --- OfflineOptions -----------------------------------------------------------------
+/*! Instead of serving the requests of an audio encoder, the PAD is written
+ * to a file, with the requests simulated as fast as possible.
+ */
+struct OfflineOptions {
+    std::string output_file;
+    int padlen = 58;
+    size_t frames = 25000;
+    double frame_duration = 24; // ms
+
+    bool Enabled() const { return !output_file.empty(); }
+};
+
+
+// --- control_slide_t -----------------------------------------------------------------
+/*! A slide received via control socket, until it has been transmitted.
+ */
+struct control_slide_t {
+    uint8_vector_t data;
+    bool priority;
+    steady_clock::time_point received;
+    int tag;        // of its DGs (see DATA_GROUP::tag); 0 = not enqueued (yet/again)
+};
+
+
 // --- PadEncoder -----------------------------------------------------------------
 class PadEncoder {
 protected:
     PadEncoderOptions options;
+    FileWatcher file_watcher;
+    std::map<std::string, unsigned long> file_change_counts;
     PADPacketizer pad_packetizer;
     DLSEncoder dls_encoder;
     SLSEncoder sls_encoder;
     SlideStore slides;
     bool slides_success;
+    std::vector<slide_metadata_t> carousel_slides;
+    bool resume_carousel;
+    std::deque<control_slide_t> control_slides;
+    int next_slide_tag;
+    steady_clock::time_point carousel_slides_inserted;
     bool label_warn_shown;
     int curr_dls_file;
+    bool control_label;
+    std::string control_label_content;  // as received (to be carried over to a new PadEncoder)
     steady_clock::time_point next_slide;
     steady_clock::time_point next_label;
     steady_clock::time_point next_label_insertion;
+    steady_clock::time_point prev_pad;
+    double frame_duration;      // ms
+    size_t label_pad_count_reported;
     size_t xpad_interval_counter;
 
-    int EncodeSlide();
+    int EncodeSlide(steady_clock::time_point pad_timeline);
     int EncodeLabel();
+    void AbortSlidesForPrioritySlide();
+    void EncodeControlSlides();
+    bool PrioritySlideQueued() const;
+    void HandleControlMessages(ControlInterface& control_intf, steady_clock::time_point pad_timeline);
+    int GetLabelInsertionInterval();
+    bool FileMayHaveChanged(const std::string& path);
     static int CheckRereadFile(const std::string& type, const std::string& path);
 
 public:
-    PadEncoder(PadEncoderOptions options);
-    virtual ~PadEncoder() {}
+    static const double LABEL_MAX_DUTY_CYCLE_SLS;
+    static const int SLIDE_TAG_CAROUSEL;
 
-    int Encode(PadInterface& intf);
+    PadEncoder(PadEncoderOptions options);
+    virtual ~PadEncoder();
+
+    /*! Encodes the PAD requested at pad_timeline (the current time, except
+     * for offline encoding).
+     */
+    int Encode(steady_clock::time_point pad_timeline, ControlInterface* control_intf, std::vector<uint8_t>& pad);
+
+    /*! Uses the given label (as received via control socket) instead of the
+     * DLS file(s).
+     */
+    void SetControlLabel(const std::string& content);
+
+    /*! Returns whether a label received via control socket is used, and if
+     * so, its content (e.g. to pass it to a new PadEncoder).
+     */
+    bool GetControlLabel(std::string& content) const;
 };
 
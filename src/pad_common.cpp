@@ -36,6 +36,7 @@ DATA_GROUP::DATA_GROUP(size_t len, int apptype_start, int apptype_cont) {
     this->apptype_start = apptype_start;
     this->apptype_cont = apptype_cont;
     written = 0;
+    tag = 0;
 }
 
 void DATA_GROUP::AppendCRC() {
@@ -74,6 +75,22 @@ int DATA_GROUP::Write(uint8_t *write_data, size_t len, int *cont_apptype) {
 }
 
 
+// --- pad_stats_t -----------------------------------------------------------------
+void pad_stats_t::Print() const {
+    if (xpad_bytes == 0)
+        return;
+
+    fprintf(stderr, "ODR-PadEnc X-PAD usage: %zu X-PADs (%zu Bytes): DGs %.1f%%, DGLIs %.1f%%, CIs %.1f%%, padding %.1f%%; "
+            "%zu of %zu DGLIs moved to the X-PAD of their DG start\n",
+            xpads, xpad_bytes,
+            100.0 * dg_bytes / xpad_bytes,
+            100.0 * dgli_bytes / xpad_bytes,
+            100.0 * ci_bytes / xpad_bytes,
+            100.0 * (xpad_bytes - dg_bytes - dgli_bytes - ci_bytes) / xpad_bytes,
+            dglis_moved, dglis);
+}
+
+
 // --- PADPacketizer -----------------------------------------------------------------
 const size_t PADPacketizer::SUBFIELD_LENS[]     = {4, 6, 8, 12, 16, 24, 32, 48};
 const size_t PADPacketizer::FPAD_LEN            =   2;
@@ -82,12 +99,14 @@ const size_t PADPacketizer::VARSIZE_PAD_MIN     =   8; // F-PAD + 1x CI + end ma
 const size_t PADPacketizer::VARSIZE_PAD_MAX     = 196; // F-PAD + 4x CI              + 4x 48 bytes data sub-field
 const std::string PADPacketizer::ALLOWED_PADLEN = "6 (short X-PAD), 8 to 196 (variable size X-PAD)";
 const int PADPacketizer::APPTYPE_DGLI = 1;
+const int PADPacketizer::ANY_TAG = -1;
 
 PADPacketizer::PADPacketizer(size_t pad_size) :
     xpad_size_max(pad_size - FPAD_LEN),
     short_xpad(pad_size == SHORT_PAD),
     max_cis(short_xpad ? 1 : 4),
-    last_ci_type(-1)
+    last_ci_type(-1),
+    move_dglis(-1)
 {
     ResetPAD();
 }
@@ -99,25 +118,106 @@ PADPacketizer::~PADPacketizer() {
     }
 }
 
+std::deque<DATA_GROUP*>::iterator PADPacketizer::PrependPosition(int apptype_start) {
+    /*! Never interrupt an already started DG of the same application.
+     * Also never interrupt a started DG whose continuation could not be
+     * distinguished from a new DG (i.e. a DGLI at short X-PAD).
+     */
+    std::deque<DATA_GROUP*>::iterator pos = queue.begin();
+    for (std::deque<DATA_GROUP*>::iterator it = queue.begin(); it != queue.end(); it++)
+        if (((*it)->apptype_start == apptype_start || (*it)->apptype_start == (*it)->apptype_cont) && (*it)->written > 0)
+            pos = it + 1;
+    return pos;
+}
+
 void PADPacketizer::AddDG(DATA_GROUP* dg, bool prepend) {
-    queue.insert(prepend ? queue.begin() : queue.end(), dg);
+    queue.insert(prepend ? PrependPosition(dg->apptype_start) : queue.end(), dg);
 }
 
 void PADPacketizer::AddDGs(const std::vector<DATA_GROUP*>& dgs, bool prepend) {
-    queue.insert(prepend ? queue.begin() : queue.end(), dgs.cbegin(), dgs.cend());
+    if (dgs.empty())
+        return;
+    queue.insert(prepend ? PrependPosition(dgs.front()->apptype_start) : queue.end(), dgs.cbegin(), dgs.cend());
 }
 
 bool PADPacketizer::QueueFilled() {
     return !queue.empty();
 }
 
-bool PADPacketizer::QueueContainsDG(int apptype_start) {
+bool PADPacketizer::QueueContainsDG(int apptype_start, int tag) {
     for (const DATA_GROUP* dg : queue)
-        if (dg->apptype_start == apptype_start)
+        if (dg->apptype_start == apptype_start && (tag == ANY_TAG || dg->tag == tag))
             return true;
     return false;
 }
 
+size_t PADPacketizer::RemoveUnstartedDGs(int apptype_start, bool with_dgli, int tag) {
+    /*! Remove only whole DGs, so that a started DG is still completed.
+     *
+     * If the DGs are preceded by a DGLI, a DG is only removed together with
+     * its (then also unstarted) DGLI. The first DG without a DGLI in the
+     * queue is kept, as its DGLI has already been transmitted.
+     *
+     * If a tag is given, DGs with a different tag are kept.
+     */
+    std::deque<DATA_GROUP*> kept;
+    DATA_GROUP* dgli = NULL;
+    bool first_dg = true;
+    size_t removed = 0;
+
+    for (DATA_GROUP* dg : queue) {
+        if (with_dgli && dg->apptype_start == APPTYPE_DGLI) {
+            // decide together with the following DG
+            dgli = dg;
+            continue;
+        }
+        if (dg->apptype_start != apptype_start) {
+            kept.push_back(dg);
+            continue;
+        }
+
+        bool remove = dg->written == 0 && (tag == ANY_TAG || dg->tag == tag);
+        if (with_dgli)
+            remove &= dgli ? dgli->written == 0 : !first_dg;
+        first_dg = false;
+
+        if (remove) {
+            removed += dgli ? 2 : 1;
+            delete dgli;
+            delete dg;
+        } else {
+            if (dgli)
+                kept.push_back(dgli);
+            kept.push_back(dg);
+        }
+        dgli = NULL;
+    }
+
+    // a trailing DGLI without DG (should not happen)
+    if (dgli)
+        kept.push_back(dgli);
+
+    queue.swap(kept);
+    return removed;
+}
+
+size_t PADPacketizer::GetPADCount(const std::vector<DATA_GROUP>& dgs, pad_stats_t* dgs_stats) const {
+    // packetize copies of the DGs to get the exact number of needed X-PADs
+    PADPacketizer packetizer(xpad_size_max + FPAD_LEN);
+    for (const DATA_GROUP& dg : dgs)
+        packetizer.AddDG(new DATA_GROUP(dg), false);
+
+    size_t count = 0;
+    while (packetizer.QueueFilled()) {
+        delete packetizer.GetPAD();
+        count++;
+    }
+
+    if (dgs_stats)
+        *dgs_stats = packetizer.stats;
+    return count;
+}
+
 pad_t* PADPacketizer::GetPAD() {
     bool pad_flushable = false;
 
@@ -125,6 +225,12 @@ pad_t* PADPacketizer::GetPAD() {
     while (!pad_flushable && !queue.empty()) {
         DATA_GROUP* dg = queue.front();
 
+        // a DGLI shall rather start the next X-PAD than be separated from the start of its DG
+        if (dg->apptype_start == APPTYPE_DGLI && dg->written == 0 && subfields_size > 0 && !DGLIFitsWithDGStart() && MoveDGLI()) {
+            stats.dglis_moved++;
+            break;
+        }
+
         // repeatedly append DG
         while (!pad_flushable && dg->Available() > 0)
             pad_flushable = AppendDG(dg);
@@ -140,6 +246,13 @@ pad_t* PADPacketizer::GetPAD() {
 }
 
 std::vector<uint8_t> PADPacketizer::GetNextPAD(bool output_xpad) {
+    /*! A PAD w/o X-PAD ends the continuation w/o CI. So never interrupt a
+     * started DG whose continuation (w/ CI) could not be distinguished from
+     * a new DG (i.e. a DGLI at short X-PAD).
+     */
+    if (!output_xpad && !queue.empty() && queue.front()->written > 0 && queue.front()->apptype_start == queue.front()->apptype_cont)
+        output_xpad = true;
+
     pad_t* pad = output_xpad ? GetPAD() : FlushPAD();
 
     if (verbose >= 2) {
@@ -174,8 +287,66 @@ void PADPacketizer::AddCI(int apptype, int len_index) {
     ci_type[used_cis] = apptype;
     ci_len_index[used_cis] = len_index;
 
-    xpad_size += AddCINeededBytes();
+    size_t ci_bytes = AddCINeededBytes();
+    xpad_size += ci_bytes;
     used_cis++;
+
+    if (apptype == APPTYPE_DGLI)
+        stats.dgli_bytes += ci_bytes;
+    else
+        stats.ci_bytes += ci_bytes;
+}
+
+bool PADPacketizer::MoveDGLI() const {
+    if (move_dglis != -1)
+        return move_dglis;
+
+    /*! Moving the DGLI wastes the rest of the current X-PAD and affects the
+     * size of the following X-PADs w/o CI. So the DGLI is only moved, if
+     * this does not need more X-PADs (or bytes of the last one) to transmit
+     * the DGLI and its DG.
+     */
+    return SimulateFrontDGs(2, 1) <= SimulateFrontDGs(2, 0);
+}
+
+std::pair<size_t, size_t> PADPacketizer::SimulateFrontDGs(size_t dg_count, int move_dglis) const {
+    // packetize copies of the first DGs, continuing the current X-PAD
+    PADPacketizer packetizer(xpad_size_max + FPAD_LEN);
+    packetizer.move_dglis = move_dglis;
+
+    packetizer.xpad_size = xpad_size;
+    memcpy(packetizer.subfields, subfields, subfields_size);
+    packetizer.subfields_size = subfields_size;
+    memcpy(packetizer.ci_type, ci_type, sizeof(ci_type));
+    memcpy(packetizer.ci_len_index, ci_len_index, sizeof(ci_len_index));
+    packetizer.used_cis = used_cis;
+    packetizer.last_ci_type = last_ci_type;
+    packetizer.last_ci_size = last_ci_size;
+
+    for (size_t i = 0; i < dg_count && i < queue.size(); i++)
+        packetizer.AddDG(new DATA_GROUP(*queue[i]), false);
+
+    size_t count = 0;
+    while (packetizer.QueueFilled()) {
+        delete packetizer.GetPAD();
+        count++;
+    }
+
+    // the bytes used in the last X-PAD are not available for the next DG
+    return std::make_pair(count, packetizer.last_ci_size);
+}
+
+bool PADPacketizer::DGLIFitsWithDGStart() {
+    /*! Check whether a DGLI (one smallest sub-field) and the start of its DG
+     * (another smallest sub-field) both fit into the current X-PAD.
+     * Short X-PAD only holds one sub-field anyway.
+     */
+    if (short_xpad || used_cis + 2 > max_cis)
+        return false;
+
+    size_t needed = SUBFIELD_LENS[0] + AddCINeededBytes();
+    needed += SUBFIELD_LENS[0] + (used_cis + 1 == max_cis - 1 ? 0 : 1);
+    return needed <= xpad_size_max - xpad_size;
 }
 
 
@@ -198,6 +369,14 @@ int PADPacketizer::OptimalSubFieldSizeIndex(size_t available_bytes) {
 }
 
 int PADPacketizer::WriteDGToSubField(DATA_GROUP* dg, size_t len) {
+    if (dg->apptype_start == APPTYPE_DGLI) {
+        stats.dgli_bytes += std::min(len, dg->Available());
+        if (dg->written == 0)
+            stats.dglis++;
+    } else {
+        stats.dg_bytes += std::min(len, dg->Available());
+    }
+
     int apptype = dg->Write(&subfields[subfields_size], len, &last_ci_type);
     subfields_size += len;
     xpad_size += len;
@@ -310,6 +489,11 @@ pad_t* PADPacketizer::FlushPAD() {
     // used PAD len
     pad[xpad_size_max + FPAD_LEN] = xpad_size + FPAD_LEN;
 
+    if (subfields_size > 0) {
+        stats.xpads++;
+        stats.xpad_bytes += xpad_size_max;
+    }
+
     last_ci_size = xpad_size;
     ResetPAD();
     return result;
@@ -329,6 +513,16 @@ DATA_GROUP* PADPacketizer::CreateDataGroupLengthIndicator(size_t len) {
     return dg;
 }
 
+size_t PADPacketizer::ShortXPADCount(size_t dg_len) {
+    // the first X-PAD has a CI, the following ones continue the DG w/o CI
+    const size_t len_with_ci = SHORT_PAD - FPAD_LEN - 1;
+    const size_t len_without_ci = SHORT_PAD - FPAD_LEN;
+
+    if (dg_len <= len_with_ci)
+        return 1;
+    return 1 + (dg_len - len_with_ci + len_without_ci - 1) / len_without_ci;
+}
+
 bool PADPacketizer::CheckPADLen(size_t len) {
     return len == PADPacketizer::SHORT_PAD || (len >= PADPacketizer::VARSIZE_PAD_MIN && len <= PADPacketizer::VARSIZE_PAD_MAX);
 }
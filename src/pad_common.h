@@ -37,8 +37,10 @@
 #include <string>
 #include <stdint.h>
 #include <unistd.h>
+#include <utility>
 
 #include "crc.h"
+#include "charset.h"
 
 
 
@@ -46,22 +48,13 @@ typedef std::vector<uint8_t> uint8_vector_t;
 typedef uint8_vector_t pad_t;
 
 
-// Charsets from TS 101 756
-enum class DABCharset : uint8_t {
-    COMPLETE_EBU_LATIN      =  0, //!< Complete EBU Latin based repertoire
-    EBU_LATIN_CY_GR         =  1, //!< EBU Latin based common core, Cyrillic, Greek
-    EBU_LATIN_AR_HE_CY_GR   =  2, //!< EBU Latin based core, Arabic, Hebrew, Cyrillic and Greek
-    ISO_LATIN_ALPHABET_2    =  3, //!< ISO Latin Alphabet No 2
-    UCS2_BE                 =  6, //!< ISO/IEC 10646 using UCS-2 transformation format, big endian byte order
-    UTF8                    = 15  //!< ISO Latin Alphabet No 2
-};
-
 // --- DATA_GROUP -----------------------------------------------------------------
 struct DATA_GROUP {
     uint8_vector_t data;
     int apptype_start;
     int apptype_cont;
     size_t written;
+    int tag;        // set by the encoder, to tell apart DGs of the same app type (0 = none)
 
     DATA_GROUP(size_t len, int apptype_start, int apptype_cont);
     void AppendCRC();
@@ -70,6 +63,22 @@ struct DATA_GROUP {
 };
 
 
+// --- pad_stats_t -----------------------------------------------------------------
+/*! How the X-PAD bytes output by a PADPacketizer were used.
+ */
+struct pad_stats_t {
+    size_t xpads = 0;           // X-PADs output
+    size_t xpad_bytes = 0;      // X-PAD capacity of these X-PADs
+    size_t dg_bytes = 0;        // DG bytes (excl. DGLIs)
+    size_t dgli_bytes = 0;      // DGLI bytes incl. their CIs
+    size_t ci_bytes = 0;        // CI list bytes (excl. DGLI CIs) incl. end markers
+    size_t dglis = 0;           // DGLIs output
+    size_t dglis_moved = 0;     // DGLIs moved to the next X-PAD, to be together with the start of their DG
+
+    void Print() const;
+};
+
+
 // --- PADPacketizer -----------------------------------------------------------------
 class PADPacketizer {
 private:
@@ -85,6 +94,8 @@ private:
 
     std::deque<DATA_GROUP*> queue;
 
+    std::deque<DATA_GROUP*>::iterator PrependPosition(int apptype_start);
+
     size_t xpad_size;
     uint8_t subfields[4*48];
     size_t subfields_size;
@@ -98,8 +109,16 @@ private:
     int last_ci_type;
     size_t last_ci_size;
 
+    pad_stats_t stats;
+
+    // whether to move a DGLI to the next X-PAD: -1 = if not worse, 0 = never, 1 = always
+    int move_dglis;
+
     size_t AddCINeededBytes();
     void AddCI(int apptype, int len_index);
+    bool DGLIFitsWithDGStart();
+    bool MoveDGLI() const;
+    std::pair<size_t, size_t> SimulateFrontDGs(size_t dg_count, int move_dglis) const;
 
     int OptimalSubFieldSizeIndex(size_t available_bytes);
     int WriteDGToSubField(DATA_GROUP* dg, size_t len);
@@ -121,11 +140,19 @@ public:
     void AddDG(DATA_GROUP* dg, bool prepend);
     void AddDGs(const std::vector<DATA_GROUP*>& dgs, bool prepend);
     bool QueueFilled();
-    bool QueueContainsDG(int apptype_start);
+    static const int ANY_TAG;
+
+    bool QueueContainsDG(int apptype_start, int tag = ANY_TAG);
+    size_t RemoveUnstartedDGs(int apptype_start, bool with_dgli = false, int tag = ANY_TAG);
+    size_t GetPADCount(const std::vector<DATA_GROUP>& dgs, pad_stats_t* dgs_stats = nullptr) const;
+    const pad_stats_t& GetStats() const {return stats;}
+    bool IsShortXPAD() const {return short_xpad;}
+    size_t GetXPADSize() const {return xpad_size_max;}
 
     std::vector<uint8_t> GetNextPAD(bool output_xpad);
 
     static DATA_GROUP* CreateDataGroupLengthIndicator(size_t len);
+    static size_t ShortXPADCount(size_t dg_len);
     static bool CheckPADLen(size_t len);
 };
 
@@ -0,0 +1,652 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file pad_decoder.cpp
+    \brief Decoder for the PAD output by ODR-PadEnc (DLS and MOT Slideshow)
+*/
+
+#include "pad_decoder.h"
+#include "crc.h"
+
+#include <algorithm>
+
+
+// --- pad_decoder_stats_t -----------------------------------------------------------------
+void pad_decoder_stats_t::Print(FILE* f) const {
+    fprintf(f, "ODR-PadDec %zu PADs, %zu X-PADs (%zu Bytes)", frames, xpads, xpad_bytes);
+    if (xpad_bytes > 0) {
+        fprintf(f, ": DGs %.1f%%, CIs %.1f%%, padding/other %.1f%%",
+                100.0 * dg_bytes / xpad_bytes,
+                100.0 * ci_bytes / xpad_bytes,
+                100.0 * (xpad_bytes - dg_bytes - ci_bytes) / xpad_bytes);
+    }
+    fprintf(f, "\n");
+
+    fprintf(f, "ODR-PadDec DGs: %zu OK (%zu Bytes), %zu CRC errors, %zu incomplete, %zu orphaned continuations; %zu format errors\n",
+            dgs, dg_bytes, dgs_crc_error, dgs_incomplete, dgs_orphaned, format_errors);
+
+    fprintf(f, "ODR-PadDec payload: labels %zu Bytes, MOT bodies %zu Bytes, MOT headers/directories %zu Bytes",
+            label_bytes, mot_body_bytes, mot_header_bytes);
+    if (xpad_bytes > 0)
+        fprintf(f, " (labels + MOT bodies = %.1f%% of the X-PAD)", 100.0 * (label_bytes + mot_body_bytes) / xpad_bytes);
+    fprintf(f, "\n");
+
+    fprintf(f, "ODR-PadDec decoded %zu labels and %zu MOT objects\n", labels, mot_objects);
+}
+
+
+// --- PADDecoder -----------------------------------------------------------------
+const size_t PADDecoder::SUBFIELD_LENS[] = {4, 6, 8, 12, 16, 24, 32, 48};
+const size_t PADDecoder::FPAD_LEN        = 2;
+const size_t PADDecoder::DGLI_LEN        = 4;   // incl. CRC
+const int PADDecoder::APPTYPE_DGLI       = 1;
+const int PADDecoder::APPTYPE_DL_START   = 2;
+const int PADDecoder::APPTYPE_DL_CONT    = 3;
+const int PADDecoder::APPTYPE_MOT_START  = 12;
+const int PADDecoder::APPTYPE_MOT_CONT   = 13;
+
+PADDecoder::PADDecoder() :
+    frame(0),
+    used_len(0),
+    last_apptype(-1),
+    last_xpad_size(0),
+    mot_dg_len(0),
+    dl_last_segment(-1),
+    dl_toggle(false),
+    dl_charset(DABCharset::COMPLETE_EBU_LATIN),
+    dl_first_frame(0),
+    keep_dgs(false)
+{}
+
+int PADDecoder::ContinuationAppType(int apptype) {
+    // a DG started with the start app type is continued with the continuation app type
+    if (apptype == APPTYPE_DL_START)
+        return APPTYPE_DL_CONT;
+    if (apptype == APPTYPE_MOT_START)
+        return APPTYPE_MOT_CONT;
+    return apptype;
+}
+
+bool PADDecoder::CheckCRC(const std::vector<uint8_t>& dg) {
+    if (dg.size() < 2)
+        return false;
+
+    uint16_t crc = 0xFFFF;
+    crc = odr::crc16(crc, &dg[0], dg.size() - 2);
+    crc = ~crc;
+    return dg[dg.size() - 2] == ((crc & 0xFF00) >> 8) && dg[dg.size() - 1] == (crc & 0x00FF);
+}
+
+void PADDecoder::ProcessPAD(const uint8_t* pad, size_t len) {
+    stats.frames++;
+    used_len = std::min(len, FPAD_LEN);
+
+    if (len < FPAD_LEN) {
+        stats.format_errors++;
+        last_apptype = -1;
+        frame++;
+        return;
+    }
+
+    // F-PAD: type 0 (with X-PAD indicator and CI flag)
+    size_t xpad_len = len - FPAD_LEN;
+    uint8_t fpad_type = pad[xpad_len] >> 6;
+    uint8_t xpad_ind = (pad[xpad_len] >> 4) & 0x03;
+    bool ci_flag = pad[xpad_len + 1] & 0x02;
+
+    if (fpad_type != 0 || xpad_ind == 3) {
+        stats.format_errors++;
+        last_apptype = -1;
+        frame++;
+        return;
+    }
+
+    // no X-PAD
+    if (xpad_ind == 0) {
+        last_apptype = -1;
+        frame++;
+        return;
+    }
+
+    // X-PAD (in transmission order)
+    std::vector<uint8_t> xpad(pad, pad + xpad_len);
+    std::reverse(xpad.begin(), xpad.end());
+    bool short_xpad = xpad_ind == 1;
+
+    stats.xpads++;
+    stats.xpad_bytes += xpad_len;
+
+    if (ci_flag) {
+        // X-PAD w/ CI list
+        std::vector<std::pair<int, size_t>> subfields;
+        size_t pos = 0;
+
+        if (short_xpad) {
+            // one CI, one sub-field of 3 bytes
+            if (xpad_len >= 4)
+                subfields.emplace_back(xpad[pos++] & 0x1F, 3);
+        } else {
+            // up to four CIs, terminated by an end marker (if less than four)
+            while (subfields.size() < 4 && pos < xpad_len) {
+                uint8_t ci = xpad[pos++];
+                if ((ci & 0x1F) == 0)
+                    break;
+                subfields.emplace_back(ci & 0x1F, SUBFIELD_LENS[ci >> 5]);
+            }
+        }
+        stats.ci_bytes += pos;
+
+        size_t xpad_size = pos;
+        for (const auto& subfield : subfields)
+            xpad_size += subfield.second;
+        if (subfields.empty() || xpad_size > xpad_len) {
+            stats.format_errors++;
+            last_apptype = -1;
+            frame++;
+            return;
+        }
+
+        for (const auto& subfield : subfields) {
+            ProcessSubField(subfield.first, true, xpad.data() + pos, subfield.second);
+            pos += subfield.second;
+        }
+
+        last_apptype = subfields.back().first;
+        last_xpad_size = xpad_size;
+        used_len = FPAD_LEN + xpad_size;
+    } else {
+        // X-PAD w/o CI list: continues the last sub-field (with the size of the last X-PAD)
+        if (last_apptype == -1 || last_xpad_size > xpad_len) {
+            stats.format_errors++;
+            frame++;
+            return;
+        }
+
+        ProcessSubField(ContinuationAppType(last_apptype), false, xpad.data(), last_xpad_size);
+        used_len = FPAD_LEN + last_xpad_size;
+    }
+
+    frame++;
+}
+
+void PADDecoder::AppendToDG(dg_assembly_t& dg, bool start, const uint8_t* data, size_t len) {
+    if (start) {
+        if (dg.active)
+            stats.dgs_incomplete++;
+        dg.data.assign(data, data + len);
+        dg.len = 0;
+        dg.first_frame = frame;
+        dg.active = true;
+    } else {
+        // a continuation without start (e.g. when the decoding started within a DG)
+        if (!dg.active) {
+            stats.dgs_orphaned++;
+            return;
+        }
+        dg.data.insert(dg.data.end(), data, data + len);
+    }
+}
+
+bool PADDecoder::DGComplete(dg_assembly_t& dg, int apptype) {
+    if (!dg.active || dg.len == 0 || dg.data.size() < dg.len)
+        return false;
+
+    // the rest of the last sub-field is padding
+    dg.data.resize(dg.len);
+    dg.active = false;
+
+    if (!CheckCRC(dg.data)) {
+        stats.dgs_crc_error++;
+        return false;
+    }
+
+    stats.dgs++;
+    stats.dg_bytes += dg.len;
+
+    if (keep_dgs) {
+        decoded_dg_t decoded_dg;
+        decoded_dg.apptype = apptype;
+        decoded_dg.data = dg.data;
+        decoded_dg.first_frame = dg.first_frame;
+        decoded_dg.last_frame = frame;
+        dgs.push_back(decoded_dg);
+    }
+    return true;
+}
+
+void PADDecoder::ProcessSubField(int apptype, bool with_ci, const uint8_t* data, size_t len) {
+    switch (apptype) {
+    case APPTYPE_DGLI:
+        // (at short X-PAD, the continuation of a DGLI has the same app type)
+        AppendToDG(dgli, with_ci, data, len);
+        dgli.len = DGLI_LEN;
+        if (DGComplete(dgli, APPTYPE_DGLI))
+            ProcessDGLI(dgli.data);
+        break;
+    case APPTYPE_DL_START:
+    case APPTYPE_DL_CONT:
+        AppendToDG(dl_dg, apptype == APPTYPE_DL_START, data, len);
+        if (dl_dg.active && dl_dg.len == 0 && dl_dg.data.size() >= 2) {
+            // prefix: length of the character/command field
+            const uint8_t prefix0 = dl_dg.data[0];
+            const uint8_t prefix1 = dl_dg.data[1];
+            if (!(prefix0 & 0x10))
+                dl_dg.len = 2 + (prefix0 & 0x0F) + 1 + 2;
+            else if ((prefix0 & 0x0F) == 0x2)   // DL Plus command
+                dl_dg.len = 2 + (prefix1 & 0x0F) + 1 + 2;
+            else
+                dl_dg.len = 2 + 2;
+        }
+        if (DGComplete(dl_dg, APPTYPE_DL_START))
+            ProcessDLDG(dl_dg.data, dl_dg.first_frame);
+        break;
+    case APPTYPE_MOT_START:
+    case APPTYPE_MOT_CONT:
+        AppendToDG(mot_dg, apptype == APPTYPE_MOT_START, data, len);
+        if (mot_dg.active && mot_dg.len == 0) {
+            // the length is signalled by the preceding DGLI
+            if (mot_dg_len == 0) {
+                stats.dgs_incomplete++;
+                mot_dg.active = false;
+                break;
+            }
+            mot_dg.len = mot_dg_len;
+            mot_dg_len = 0;
+        }
+        if (DGComplete(mot_dg, APPTYPE_MOT_START))
+            ProcessMOTDG(mot_dg.data, mot_dg.first_frame);
+        break;
+    default:
+        // other X-PAD applications are not decoded
+        break;
+    }
+}
+
+void PADDecoder::ProcessDGLI(const std::vector<uint8_t>& dg) {
+    mot_dg_len = ((dg[0] & 0x3F) << 8) | dg[1];
+}
+
+void PADDecoder::ProcessDLDG(const std::vector<uint8_t>& dg, size_t first_frame) {
+    const uint8_t prefix0 = dg[0];
+    bool toggle = prefix0 & 0x80;
+    bool first_seg = prefix0 & 0x40;
+    bool last_seg = prefix0 & 0x20;
+
+    // command
+    if (prefix0 & 0x10) {
+        switch (prefix0 & 0x0F) {
+        case 0x1:   // remove label
+            dl_segments.clear();
+            break;
+        case 0x2:   // DL Plus
+            ProcessDLPlusCommand(dg);
+            break;
+        }
+        return;
+    }
+
+    // segment (the rfa bits - and so also a segment number beyond 7 - are invalid)
+    if (dg[1] & (first_seg ? 0x0F : 0x8F)) {
+        stats.format_errors++;
+        return;
+    }
+    size_t seg_len = (prefix0 & 0x0F) + 1;
+    std::string seg_text(dg.begin() + 2, dg.begin() + 2 + seg_len);
+    stats.label_bytes += seg_len;
+
+    int seg_index;
+    if (first_seg) {
+        dl_segments.clear();
+        dl_last_segment = -1;
+        dl_toggle = toggle;
+        dl_charset = (DABCharset) (dg[1] >> 4);
+        dl_first_frame = first_frame;
+        seg_index = 0;
+    } else {
+        // further segments are only of use together with the first one
+        if (dl_segments.empty() || toggle != dl_toggle)
+            return;
+        seg_index = (dg[1] >> 4) & 0x07;
+    }
+
+    dl_segments[seg_index] = seg_text;
+    if (last_seg)
+        dl_last_segment = seg_index;
+
+    // label complete?
+    if (dl_last_segment == -1)
+        return;
+    decoded_label_t label;
+    for (int i = 0; i <= dl_last_segment; i++) {
+        std::map<int, std::string>::const_iterator it = dl_segments.find(i);
+        if (it == dl_segments.end())
+            return;
+        label.text += it->second;
+    }
+
+    label.charset = dl_charset;
+    label.text_utf8 = CharsetConverter::is_supported(dl_charset) ? charset_converter.decode(label.text, dl_charset) : label.text;
+    label.toggle = dl_toggle;
+    label.first_frame = dl_first_frame;
+    label.last_frame = frame;
+    labels.push_back(label);
+    stats.labels++;
+
+    dl_segments.clear();
+    dl_last_segment = -1;
+}
+
+void PADDecoder::ProcessDLPlusCommand(const std::vector<uint8_t>& dg) {
+    // prefix + command field (at least CId/IT/IR/NT) + CRC
+    size_t field_len = (dg[1] & 0x0F) + 1;
+    if (dg.size() < 2 + field_len + 2 || field_len < 1) {
+        stats.format_errors++;
+        return;
+    }
+
+    // only the DL Plus tags command is decoded
+    if ((dg[2] >> 4) != 0x0)
+        return;
+
+    decoded_dl_plus_t command;
+    command.link_toggle = dg[1] & 0x80;
+    command.item_toggle = dg[2] & 0x08;
+    command.item_running = dg[2] & 0x04;
+    command.frame = frame;
+
+    size_t tags = (dg[2] & 0x03) + 1;
+    if (field_len < 1 + 3 * tags) {
+        stats.format_errors++;
+        return;
+    }
+    for (size_t i = 0; i < tags; i++) {
+        decoded_dl_plus_t::tag_t tag;
+        tag.content_type  = dg[3 + 3 * i] & 0x7F;
+        tag.start_marker  = dg[4 + 3 * i] & 0x7F;
+        tag.length_marker = dg[5 + 3 * i] & 0x7F;
+        command.tags.push_back(tag);
+    }
+
+    dl_plus_commands.push_back(command);
+}
+
+void PADDecoder::ProcessMOTDG(const std::vector<uint8_t>& dg, size_t first_frame) {
+    // MSC data group header (EN 300 401 v2.1.1, ch. 5.3.3)
+    bool ext_flag = dg[0] & 0x80;
+    bool crc_flag = dg[0] & 0x40;
+    bool seg_flag = dg[0] & 0x20;
+    bool acc_flag = dg[0] & 0x10;
+    int dgtype = dg[0] & 0x0F;
+
+    size_t end = dg.size() - (crc_flag ? 2 : 0);
+    size_t pos = 2 + (ext_flag ? 2 : 0);
+
+    // MOT needs the segment field and the TransportId
+    if (!seg_flag || !acc_flag || pos + 3 > end) {
+        stats.format_errors++;
+        return;
+    }
+
+    // session header: segment field
+    bool last_seg = dg[pos] & 0x80;
+    int seg_index = ((dg[pos] & 0x7F) << 8) | dg[pos + 1];
+    pos += 2;
+
+    // session header: user access field
+    bool tid_flag = dg[pos] & 0x10;
+    size_t len_ind = dg[pos] & 0x0F;
+    pos++;
+    if (!tid_flag || len_ind < 2 || pos + len_ind + 2 > end) {
+        stats.format_errors++;
+        return;
+    }
+    int tid = (dg[pos] << 8) | dg[pos + 1];
+    pos += len_ind;
+
+    // MOT segmentation header
+    size_t seg_len = ((dg[pos] & 0x1F) << 8) | dg[pos + 1];
+    pos += 2;
+    if (pos + seg_len > end) {
+        stats.format_errors++;
+        return;
+    }
+
+    switch (dgtype) {
+    case 3:     // MOT header
+    case 6:     // MOT directory (uncompressed)
+        stats.mot_header_bytes += seg_len;
+        break;
+    case 4:     // MOT body (unscrambled)
+        stats.mot_body_bytes += seg_len;
+        break;
+    default:
+        return;
+    }
+
+    mot_assembly_t& assembly = mot_assemblies[std::make_pair(dgtype, tid)];
+    if (assembly.segments.empty())
+        assembly.first_frame = first_frame;
+    assembly.segments[seg_index].assign(dg.begin() + pos, dg.begin() + pos + seg_len);
+    if (last_seg)
+        assembly.last_segment = seg_index;
+
+    // object complete?
+    if (assembly.last_segment == -1)
+        return;
+    std::vector<uint8_t> data;
+    for (int i = 0; i <= assembly.last_segment; i++) {
+        std::map<int, std::vector<uint8_t>>::const_iterator it = assembly.segments.find(i);
+        if (it == assembly.segments.end())
+            return;
+        data.insert(data.end(), it->second.cbegin(), it->second.cend());
+    }
+
+    size_t object_first_frame = assembly.first_frame;
+    mot_assemblies.erase(std::make_pair(dgtype, tid));
+    ProcessMOTObject(dgtype, tid, data, object_first_frame);
+}
+
+void PADDecoder::ProcessMOTObject(int dgtype, int tid, const std::vector<uint8_t>& data, size_t first_frame) {
+    switch (dgtype) {
+    case 3: {   // MOT header
+        mot_header_t& header = mot_headers[tid];
+        header.data = data;
+        header.first_frame = first_frame;
+
+        // the body may have been received before
+        std::map<int, decoded_mot_object_t>::iterator body = mot_pending_bodies.find(tid);
+        if (body != mot_pending_bodies.end()) {
+            OutputMOTObject(body->second, header, false);
+            mot_pending_bodies.erase(body);
+            mot_headers.erase(tid);
+        }
+        break;
+    }
+    case 4: {   // MOT body
+        decoded_mot_object_t object;
+        object.transport_id = tid;
+        object.body = data;
+        object.first_frame = first_frame;
+
+        // a MOT header (header mode) is only used once, the MOT directory until replaced
+        std::map<int, mot_header_t>::iterator header = mot_headers.find(tid);
+        if (header != mot_headers.end()) {
+            OutputMOTObject(object, header->second, false);
+            mot_headers.erase(header);
+            break;
+        }
+        header = mot_directory.find(tid);
+        if (header != mot_directory.end()) {
+            OutputMOTObject(object, header->second, true);
+            break;
+        }
+        mot_pending_bodies[tid] = object;
+        break;
+    }
+    case 6:     // MOT directory
+        ProcessMOTDirectory(data, first_frame);
+        break;
+    }
+}
+
+void PADDecoder::ProcessMOTDirectory(const std::vector<uint8_t>& dir, size_t first_frame) {
+    // MOT directory (EN 301 234 v2.1.1, ch. 7.2.1)
+    if (dir.size() < 13) {
+        stats.format_errors++;
+        return;
+    }
+
+    size_t dir_size = ((dir[0] & 0x3F) << 24) | (dir[1] << 16) | (dir[2] << 8) | dir[3];
+    size_t object_count = (dir[4] << 8) | dir[5];
+    size_t ext_len = (dir[11] << 8) | dir[12];
+    size_t pos = 13 + ext_len;
+    if (dir_size != dir.size() || pos > dir.size()) {
+        stats.format_errors++;
+        return;
+    }
+
+    std::map<int, mot_header_t> entries;
+    for (size_t i = 0; i < object_count; i++) {
+        decoded_mot_object_t object;
+        size_t header_size = pos + 2 <= dir.size() ? ParseMOTHeader(dir.data() + pos + 2, dir.size() - pos - 2, object) : 0;
+        if (header_size == 0) {
+            stats.format_errors++;
+            return;
+        }
+
+        mot_header_t& header = entries[(dir[pos] << 8) | dir[pos + 1]];
+        header.data.assign(dir.begin() + pos + 2, dir.begin() + pos + 2 + header_size);
+        header.first_frame = first_frame;
+        pos += 2 + header_size;
+    }
+    mot_directory.swap(entries);
+
+    // bodies received before
+    for (std::map<int, decoded_mot_object_t>::iterator it = mot_pending_bodies.begin(); it != mot_pending_bodies.end();) {
+        std::map<int, mot_header_t>::const_iterator header = mot_directory.find(it->first);
+        if (header != mot_directory.end()) {
+            OutputMOTObject(it->second, header->second, true);
+            it = mot_pending_bodies.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+void PADDecoder::OutputMOTObject(decoded_mot_object_t& object, const mot_header_t& header, bool from_directory) {
+    if (ParseMOTHeader(header.data.data(), header.data.size(), object) == 0 || object.body_size != object.body.size()) {
+        stats.format_errors++;
+        return;
+    }
+
+    object.header = header.data;
+    object.from_directory = from_directory;
+    object.last_frame = frame;
+
+    // the MOT header (header mode) belongs to this transmission of the object
+    if (!from_directory)
+        object.first_frame = std::min(object.first_frame, header.first_frame);
+
+    mot_objects.push_back(object);
+    stats.mot_objects++;
+}
+
+size_t PADDecoder::ParseMOTHeader(const uint8_t* data, size_t len, decoded_mot_object_t& object) {
+    // MOT header core (EN 301 234 v2.1.1, ch. 6.1)
+    if (len < 7)
+        return 0;
+
+    size_t body_size = (data[0] << 20) | (data[1] << 12) | (data[2] << 4) | (data[3] >> 4);
+    size_t header_size = ((data[3] & 0x0F) << 9) | (data[4] << 1) | (data[5] >> 7);
+    if (header_size < 7 || header_size > len)
+        return 0;
+
+    object.body_size = body_size;
+    object.content_type = (data[5] >> 1) & 0x3F;
+    object.content_subtype = ((data[5] & 0x01) << 8) | data[6];
+    object.content_name.clear();
+
+    // MOT header extension
+    for (size_t pos = 7; pos < header_size;) {
+        int pli = data[pos] >> 6;
+        int param_id = data[pos] & 0x3F;
+        pos++;
+
+        size_t field_len = 0;
+        switch (pli) {
+        case 0x1:
+            field_len = 1;
+            break;
+        case 0x2:
+            field_len = 4;
+            break;
+        case 0x3:
+            // longer field lens use 15 instead of 7 bits
+            if (pos >= header_size)
+                return 0;
+            field_len = data[pos] & 0x7F;
+            if (data[pos++] & 0x80) {
+                if (pos >= header_size)
+                    return 0;
+                field_len = (field_len << 8) | data[pos++];
+            }
+            break;
+        }
+        if (pos + field_len > header_size)
+            return 0;
+
+        // ContentName: charset + name
+        if (param_id == 0x0C && field_len >= 1)
+            object.content_name.assign((const char*) data + pos + 1, field_len - 1);
+
+        pos += field_len;
+    }
+
+    return header_size;
+}
+
+bool PADDecoder::GetDG(decoded_dg_t& dg) {
+    if (dgs.empty())
+        return false;
+    dg = dgs.front();
+    dgs.pop_front();
+    return true;
+}
+
+bool PADDecoder::GetLabel(decoded_label_t& label) {
+    if (labels.empty())
+        return false;
+    label = labels.front();
+    labels.pop_front();
+    return true;
+}
+
+bool PADDecoder::GetDLPlusCommand(decoded_dl_plus_t& command) {
+    if (dl_plus_commands.empty())
+        return false;
+    command = dl_plus_commands.front();
+    dl_plus_commands.pop_front();
+    return true;
+}
+
+bool PADDecoder::GetMOTObject(decoded_mot_object_t& object) {
+    if (mot_objects.empty())
+        return false;
+    object = mot_objects.front();
+    mot_objects.pop_front();
+    return true;
+}
@@ -0,0 +1,256 @@
+/*
+    Copyright (C) 2026 Opendigitalradio (http://opendigitalradio.org)
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/*!
+    \file pad_decoder.h
+    \brief Decoder for the PAD output by ODR-PadEnc (DLS and MOT Slideshow)
+*/
+
+#ifndef PAD_DECODER_H_
+#define PAD_DECODER_H_
+
+#include "common.h"
+#include "charset.h"
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+
+// --- decoded_dg_t -----------------------------------------------------------------
+/*! A DG (incl. CRC) reassembled from its sub-fields, e.g. to compare it with
+ * the DG passed to the PADPacketizer.
+ */
+struct decoded_dg_t {
+    int apptype;                // start app type
+    std::vector<uint8_t> data;
+    size_t first_frame;         // frame in which the DG started
+    size_t last_frame;          // frame in which the DG was completed
+
+    decoded_dg_t() : apptype(-1), first_frame(0), last_frame(0) {}
+};
+
+
+// --- decoded_label_t -----------------------------------------------------------------
+/*! A DLS text reassembled from its segments.
+ */
+struct decoded_label_t {
+    std::string text;           // as transmitted
+    std::string text_utf8;      // converted to UTF-8 (if the charset is supported)
+    DABCharset charset;
+    bool toggle;
+    size_t first_frame;         // frame in which the first received segment started
+    size_t last_frame;          // frame in which the label was completed
+
+    decoded_label_t() : charset(DABCharset::COMPLETE_EBU_LATIN), toggle(false), first_frame(0), last_frame(0) {}
+};
+
+
+// --- decoded_dl_plus_t -----------------------------------------------------------------
+/*! A DL Plus tags command.
+ */
+struct decoded_dl_plus_t {
+    struct tag_t {
+        int content_type;
+        int start_marker;
+        int length_marker;
+    };
+
+    bool link_toggle;           // = toggle of the associated label
+    bool item_toggle;
+    bool item_running;
+    std::vector<tag_t> tags;
+    size_t frame;               // frame in which the command was completed
+
+    decoded_dl_plus_t() : link_toggle(false), item_toggle(false), item_running(false), frame(0) {}
+};
+
+
+// --- decoded_mot_object_t -----------------------------------------------------------------
+/*! A MOT object, whose body and header (from a MOT header or the MOT
+ * directory) were received completely.
+ */
+struct decoded_mot_object_t {
+    int transport_id;
+    std::vector<uint8_t> header;    // MOT header (core + extension)
+    std::vector<uint8_t> body;
+    size_t body_size;               // as signalled in the header
+    int content_type;
+    int content_subtype;
+    std::string content_name;       // w/o charset byte
+    bool from_directory;            // header taken from the MOT directory
+    size_t first_frame;             // frame in which the first received DG of the header/body started
+    size_t last_frame;              // frame in which the object was completed
+
+    decoded_mot_object_t() :
+        transport_id(-1), body_size(0), content_type(-1), content_subtype(-1),
+        from_directory(false), first_frame(0), last_frame(0) {}
+};
+
+
+// --- pad_decoder_stats_t -----------------------------------------------------------------
+/*! What the PADs processed by a PADDecoder contained.
+ */
+struct pad_decoder_stats_t {
+    size_t frames = 0;          // PADs processed
+    size_t xpads = 0;           // X-PADs among them
+    size_t xpad_bytes = 0;      // X-PAD capacity of these X-PADs
+    size_t ci_bytes = 0;        // CI list bytes incl. end markers
+    size_t dgs = 0;             // DGs received completely (incl. DGLIs)
+    size_t dg_bytes = 0;        // bytes of these DGs
+    size_t dgs_crc_error = 0;   // DGs received completely, but with wrong CRC
+    size_t dgs_incomplete = 0;  // DGs interrupted by another DG, or of unknown length
+    size_t dgs_orphaned = 0;    // continuation sub-fields w/o a DG being received
+    size_t format_errors = 0;   // invalid F-PAD, CI list or DG header/field
+    size_t label_bytes = 0;     // DLS text bytes in the DGs
+    size_t mot_body_bytes = 0;  // MOT body segment bytes in the DGs
+    size_t mot_header_bytes = 0;// MOT header/directory segment bytes in the DGs
+    size_t labels = 0;          // labels completed
+    size_t mot_objects = 0;     // MOT objects completed
+
+    void Print(FILE* f) const;
+
+    /*! Returns the number of violations of the PAD format, i.e. errors that
+     * ODR-PadEnc must never produce.
+     */
+    size_t Violations() const {return format_errors + dgs_crc_error + dgs_incomplete + dgs_orphaned;}
+};
+
+
+// --- PADDecoder -----------------------------------------------------------------
+/*! Parses PADs (F-PAD plus the reversed X-PAD in front of it, as output by
+ * PADPacketizer) and reassembles the DGs of the X-PAD applications DLS (incl.
+ * DL Plus) and MOT (in header or directory mode). The decoded labels and MOT
+ * objects can be fetched afterwards, together with the frame numbers needed
+ * for latency measurements.
+ */
+class PADDecoder {
+private:
+    static const size_t SUBFIELD_LENS[];
+    static const size_t FPAD_LEN;
+    static const size_t DGLI_LEN;
+
+    // the DG of an application currently being received
+    struct dg_assembly_t {
+        std::vector<uint8_t> data;
+        size_t len;             // expected length incl. CRC (0 = not yet known)
+        size_t first_frame;
+        bool active;
+
+        dg_assembly_t() : len(0), first_frame(0), active(false) {}
+    };
+
+    // the segments of a MOT header/body/directory received so far
+    struct mot_assembly_t {
+        std::map<int, std::vector<uint8_t>> segments;
+        int last_segment;       // -1 = unknown yet
+        size_t first_frame;
+
+        mot_assembly_t() : last_segment(-1), first_frame(0) {}
+    };
+
+    struct mot_header_t {
+        std::vector<uint8_t> data;
+        size_t first_frame;
+    };
+
+    CharsetConverter charset_converter;
+    pad_decoder_stats_t stats;
+    size_t frame;
+    size_t used_len;            // of the last PAD
+
+    // X-PAD w/o CI list: continues the last sub-field
+    int last_apptype;
+    size_t last_xpad_size;
+
+    dg_assembly_t dgli;
+    dg_assembly_t dl_dg;
+    dg_assembly_t mot_dg;
+    size_t mot_dg_len;          // as signalled by the last DGLI
+
+    // the segments of the label currently being received
+    std::map<int, std::string> dl_segments;     // segment number -> characters
+    int dl_last_segment;    // -1 = unknown yet
+    bool dl_toggle;
+    DABCharset dl_charset;
+    size_t dl_first_frame;
+
+    std::map<std::pair<int, int>, mot_assembly_t> mot_assemblies;   // (DG type, TransportId) -> segments
+    std::map<int, mot_header_t> mot_headers;                        // TransportId -> header (header mode)
+    std::map<int, mot_header_t> mot_directory;                      // TransportId -> header (directory mode)
+    std::map<int, decoded_mot_object_t> mot_pending_bodies;         // TransportId -> body w/o header yet
+
+    bool keep_dgs;
+    std::deque<decoded_dg_t> dgs;
+    std::deque<decoded_label_t> labels;
+    std::deque<decoded_dl_plus_t> dl_plus_commands;
+    std::deque<decoded_mot_object_t> mot_objects;
+
+    static int ContinuationAppType(int apptype);
+    static bool CheckCRC(const std::vector<uint8_t>& dg);
+
+    void ProcessSubField(int apptype, bool with_ci, const uint8_t* data, size_t len);
+    void AppendToDG(dg_assembly_t& dg, bool start, const uint8_t* data, size_t len);
+    bool DGComplete(dg_assembly_t& dg, int apptype);
+
+    void ProcessDGLI(const std::vector<uint8_t>& dg);
+    void ProcessDLDG(const std::vector<uint8_t>& dg, size_t first_frame);
+    void ProcessDLPlusCommand(const std::vector<uint8_t>& dg);
+    void ProcessMOTDG(const std::vector<uint8_t>& dg, size_t first_frame);
+    void ProcessMOTObject(int dgtype, int tid, const std::vector<uint8_t>& data, size_t first_frame);
+    void ProcessMOTDirectory(const std::vector<uint8_t>& dir, size_t first_frame);
+    void OutputMOTObject(decoded_mot_object_t& object, const mot_header_t& header, bool from_directory);
+public:
+    static const int APPTYPE_DGLI;
+    static const int APPTYPE_DL_START;
+    static const int APPTYPE_DL_CONT;
+    static const int APPTYPE_MOT_START;
+    static const int APPTYPE_MOT_CONT;
+
+    PADDecoder();
+
+    /*! Processes the next PAD of len bytes (X-PAD + F-PAD, i.e. without the
+     * used PAD length byte sent to the audio encoder).
+     */
+    void ProcessPAD(const uint8_t* pad, size_t len);
+
+    /*! Keeps all DGs received completely (with correct CRC), so that they
+     * can be fetched by GetDG(). Disabled by default.
+     */
+    void KeepDGs(bool keep) {keep_dgs = keep;}
+
+    bool GetDG(decoded_dg_t& dg);
+    bool GetLabel(decoded_label_t& label);
+    bool GetDLPlusCommand(decoded_dl_plus_t& command);
+    bool GetMOTObject(decoded_mot_object_t& object);
+
+    const pad_decoder_stats_t& GetStats() const {return stats;}
+    size_t GetFrameCount() const {return frame;}
+
+    /*! Returns the used length of the last PAD, i.e. the F-PAD plus the X-PAD
+     * bytes in use (CI list and sub-fields); the rest of the X-PAD is padding.
+     */
+    size_t GetUsedLen() const {return used_len;}
+
+    /*! Parses the core and extension of a MOT header.
+     *
+     * \return the header size, or 0 if the header is invalid
+     */
+    static size_t ParseMOTHeader(const uint8_t* data, size_t len, decoded_mot_object_t& object);
+};
+
+#endif /* PAD_DECODER_H_ */
@@ -95,11 +95,14 @@ uint8_t PadInterface::receive_request()
                 throw runtime_error(string("Can't receive data: ") + strerror(errno));
             }
             else {
-                buffer.resize(ret);
-
                 // We could check where the data comes from, but since we're using UNIX sockets
                 // the source is anyway local to the machine.
 
+                // ignore empty/truncated messages
+                if (ret < 2) {
+                    continue;
+                }
+
                 if (buffer[0] == MESSAGE_REQUEST) {
                     uint8_t padlen = buffer[1];
                     return padlen;
@@ -79,6 +79,22 @@ int History::get_fidx(const char* filepath)
 
     fp.load_from_file(filepath);
 
+    return get_fidx(fp);
+}
+
+
+int History::get_fidx(const uint8_vector_t& data)
+{
+    fingerprint_t fp;
+
+    fp.load_from_data(data);
+
+    return get_fidx(fp);
+}
+
+
+int History::get_fidx(fingerprint_t& fp)
+{
     int idx = find(fp);
 
     if (idx < 0) {
@@ -152,6 +168,13 @@ bool SlideStore::InitFromDir(const std::string& dir) {
     return true;
 }
 
+std::set<int> SlideStore::GetFidxs() const {
+    std::set<int> fidxs;
+    for (const slide_metadata_t& slide : slides)
+        fidxs.insert(slide.fidx);
+    return fidxs;
+}
+
 slide_metadata_t SlideStore::GetSlide() {
     // pre-condition: list non-empty
 
@@ -251,11 +274,144 @@ void MOTHeader::AddExtension(int param_id, const uint8_t* data_field, size_t dat
 }
 
 
+void MOTHeader::AddExtensions(const uint8_vector_t& extensions) {
+    data.insert(data.end(), extensions.cbegin(), extensions.cend());
+
+    IncrementHeaderSize(extensions.size());
+}
+
+
+uint8_vector_t MOTHeader::GetExtensions() const {
+    // everything after the header core
+    return uint8_vector_t(data.cbegin() + 7, data.cend());
+}
+
+
+// --- slide_cache_entry_t -----------------------------------------------------------------
+slide_cache_entry_t::~slide_cache_entry_t() {
+    if (data)
+        munmap(data, size);
+}
+
+
+// --- SlideCache -----------------------------------------------------------------
+const int SlideCache::FORMAT_VERSION = 1; // increment, if the processing of slides changes
+
+std::string SlideCache::EntryPath(const std::string& key, bool jfif_not_png) const {
+    return dir + "/" + key + (jfif_not_png ? ".jpg" : ".png");
+}
+
+std::string SlideCache::GetKey(const std::string& fname, size_t max_slide_size) const {
+    FILE* pFile = fopen(fname.c_str(), "rb");
+    if (pFile == NULL)
+        return "";
+
+    // FNV-1a (64 bit) over the file content and the encoding parameters
+    uint64_t hash = fnv1a_64(nullptr, 0);
+
+    uint8_t buffer[4096];
+    size_t len;
+    while ((len = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+        hash = fnv1a_64(buffer, len, hash);
+    bool read_error = ferror(pFile);
+    fclose(pFile);
+    if (read_error)
+        return "";
+
+    uint64_t params[] = {(uint64_t) FORMAT_VERSION, (uint64_t) max_slide_size};
+    hash = fnv1a_64((const uint8_t*) params, sizeof(params), hash);
+
+    char key[17];
+    snprintf(key, sizeof(key), "%016" PRIx64, hash);
+    return key;
+}
+
+bool SlideCache::Load(const std::string& key, slide_cache_entry_t& entry) const {
+    for (bool jfif_not_png : {true, false}) {
+        int fd = open(EntryPath(key, jfif_not_png).c_str(), O_RDONLY);
+        if (fd == -1)
+            continue;
+
+        struct stat entry_stat;
+        if (fstat(fd, &entry_stat) || entry_stat.st_size == 0) {
+            close(fd);
+            continue;
+        }
+
+        void* data = mmap(NULL, entry_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            perror(("ODR-PadEnc Error: cannot map slide cache entry '" + EntryPath(key, jfif_not_png) + "'").c_str());
+            continue;
+        }
+
+        entry.data = (uint8_t*) data;
+        entry.size = entry_stat.st_size;
+        entry.jfif_not_png = jfif_not_png;
+        return true;
+    }
+    return false;
+}
+
+void SlideCache::Store(const std::string& key, const uint8_t* blob, size_t blobsize, bool jfif_not_png) const {
+    // write to a unique temporary file first, which is then atomically renamed
+    // (the name must not depend on the PID, as encoders in different PID
+    // namespaces may share the cache dir)
+    std::string path = EntryPath(key, jfif_not_png);
+    std::vector<char> tmp_template(dir.begin(), dir.end());
+    const std::string tmp_suffix = "/." + key + ".tmp.XXXXXX";
+    tmp_template.insert(tmp_template.end(), tmp_suffix.begin(), tmp_suffix.end());
+    tmp_template.push_back('\0');
+
+    int fd = mkstemp(tmp_template.data());
+    if (fd == -1) {
+        perror(("ODR-PadEnc Error: cannot create slide cache entry in '" + dir + "'").c_str());
+        return;
+    }
+    std::string tmp_path(tmp_template.data());
+
+    // mkstemp creates the file only readable by the owner
+    bool write_error = fchmod(fd, 0644) != 0;
+    for (size_t written = 0; !write_error && written < blobsize;) {
+        ssize_t ret = write(fd, blob + written, blobsize - written);
+        if (ret == -1) {
+            if (errno == EINTR)
+                continue;
+            write_error = true;
+        } else {
+            written += ret;
+        }
+    }
+    if (close(fd))
+        write_error = true;
+
+    if (write_error) {
+        perror(("ODR-PadEnc Error: cannot write slide cache entry '" + tmp_path + "'").c_str());
+        unlink(tmp_path.c_str());
+        return;
+    }
+
+    if (rename(tmp_path.c_str(), path.c_str())) {
+        perror(("ODR-PadEnc Error: cannot publish slide cache entry '" + path + "'").c_str());
+        unlink(tmp_path.c_str());
+        return;
+    }
+
+    if (verbose)
+        fprintf(stderr, "ODR-PadEnc stored slide cache entry '%s'\n", path.c_str());
+}
+
+
 // --- SLSEncoder -----------------------------------------------------------------
-const size_t SLSEncoder::MAXSEGLEN              =  1013; // Bytes (EN 301 234 v2.1.1, ch. 5.1.1 limits to 8189); the complete DG will be 1024 bytes
+const size_t SLSEncoder::MAXSEGLEN              =  1013; // Bytes (default); the complete DG will be 1024 bytes
+const size_t SLSEncoder::MAXSEGLEN_LIMIT        =  8189; // Bytes (EN 301 234 v2.1.1, ch. 5.1.1)
+const int    SLSEncoder::MAXREPETITIONS         =     7; // RepetitionCount has 3 bits (EN 301 234 v2.1.1, ch. 5.1.1)
+const int    SLSEncoder::DIRECTORY_TID_FIRST    = 0xF000; // TransportIds of the MOT directory (beyond the fidx range)
+const int    SLSEncoder::DIRECTORY_TID_LAST     = 0xFFFF;
 const size_t SLSEncoder::MAXSLIDESIZE_SIMPLE    = 51200; // Bytes (TS 101 499 v3.1.1, ch. 9.1.2)
 const int    SLSEncoder::MINQUALITY             =    40; // Do not allow the image compressor to go below JPEG quality 40
 const std::string SLSEncoder::SLS_PARAMS_SUFFIX = ".sls_params";
+const size_t SLSEncoder::MAXPARAMSCACHELEN     =    50; // How many slide params files to keep parsed
 const int SLSEncoder::APPTYPE_MOT_START = 12;
 const int SLSEncoder::APPTYPE_MOT_CONT = 13;
 const std::string SLSEncoder::REQUEST_REREAD_FILENAME = "REQUEST_SLIDES_DIR_REREAD";
@@ -354,6 +510,92 @@ size_t SLSEncoder::resizeImage(MagickWand* m_wand, unsigned char** blob, const s
     *blob = *jfif_not_png ? blob_jpg : blob_png;
     return *jfif_not_png ? blobsize_jpg : blobsize_png;
 }
+
+size_t SLSEncoder::processImage(MagickWand* m_wand, unsigned char** blob, const std::string& fname, int fidx, bool* jfif_not_png, size_t max_slide_size)
+{
+    /*! By default, we do resize the image to 320x240, with a quality such that
+     * the blobsize is at most MAXSLIDESIZE.
+     *
+     * For JPEG input files that are already at the right resolution and at the
+     * right blobsize, we disable this to avoid quality loss due to recompression
+     *
+     * As device support of this feature is optional, we furthermore require JPEG input
+     * files to not have progressive coding.
+     */
+    bool native_support = false;
+    bool resize_required = true;
+    size_t blobsize = 0;
+
+    size_t height       = MagickGetImageHeight(m_wand);
+    size_t width        = MagickGetImageWidth(m_wand);
+    char*  orig_format  = MagickGetImageFormat(m_wand);
+    bool   jpeg_progr   = MagickGetImageInterlaceScheme(m_wand) == JPEGInterlace;
+
+    // strip unneeded information (profiles, meta data)
+    MagickStripImage(m_wand);
+
+    if (orig_format) {
+        if (strcmp(orig_format, "JPEG") == 0) {
+            size_t orig_quality = MagickGetImageCompressionQuality(m_wand);
+            native_support = true;
+
+            if (verbose) {
+                fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d)."
+                        " Original size: %zu x %zu. (%s, q=%zu, progr=%s)\n",
+                        fname.c_str(), fidx, width, height, orig_format, orig_quality, jpeg_progr ? "y" : "n");
+            }
+        }
+        else if (strcmp(orig_format, "PNG") == 0) {
+            native_support = true;
+            *jfif_not_png = false;
+
+            if (verbose) {
+                fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d)."
+                        " Original size: %zu x %zu. (%s)\n",
+                        fname.c_str(), fidx, width, height, orig_format);
+            }
+        }
+        else if (verbose) {
+            fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d)."
+                    " Original size: %zu x %zu. (%s)\n",
+                    fname.c_str(), fidx, width, height, orig_format);
+        }
+
+        free(orig_format);
+    }
+    else {
+        fprintf(stderr, "ODR-PadEnc Warning: Unable to detect image format of '%s'\n",
+                fname.c_str());
+
+        fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d).  Original size: %zu x %zu.\n",
+                fname.c_str(), fidx, width, height);
+    }
+
+    if (native_support && height <= 240 && width <= 320 && not jpeg_progr) {
+        // Don't recompress the image and check if the blobsize is suitable
+        *blob = MagickGetImageBlob(m_wand, &blobsize);
+
+        if (blobsize <= max_slide_size) {
+            if (verbose) {
+                fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d).  No resize needed: %zu Bytes\n",
+                        fname.c_str(), fidx, blobsize);
+            }
+            resize_required = false;
+        } else {
+            MagickRelinquishMemory(*blob);
+            *blob = NULL;
+        }
+    }
+
+    if (resize_required) {
+        blobsize = resizeImage(m_wand, blob, fname, jfif_not_png, max_slide_size);
+    } else {
+        // warn if unresized image smaller than default dimension
+        warnOnSmallerImage(height, width, fname, false);
+    }
+
+    return blobsize;
+}
 #endif
 
 static void dump_slide(const std::string& dump_name, const uint8_t *blob, size_t size)
@@ -395,25 +637,32 @@ bool SLSEncoder::encodeSlide(const std::string& fname, int fidx, bool raw_slides
 
     uint8_t *raw_blob = NULL;
     uint8_t *magick_blob = NULL;
-    size_t blobsize;
+    slide_cache_entry_t cached_blob;
+    std::string cache_key;
+    size_t blobsize = 0;
     bool jfif_not_png = true;
 
     const bool raw_slide = filename_specifies_raw_mode(fname) or raw_slides;
 
-    if (!raw_slide) {
-#if HAVE_MAGICKWAND
-        /*! By default, we do resize the image to 320x240, with a quality such that
-         * the blobsize is at most MAXSLIDESIZE.
-         *
-         * For JPEG input files that are already at the right resolution and at the
-         * right blobsize, we disable this to avoid quality loss due to recompression
-         *
-         * As device support of this feature is optional, we furthermore require JPEG input
-         * files to not have progressive coding.
-         */
-        bool native_support = false;
-        bool resize_required = true;
+    // processed slides may already be present in the slide cache
+    if (!raw_slide && slide_cache.Enabled()) {
+        cache_key = slide_cache.GetKey(fname, max_slide_size);
+        if (!cache_key.empty() && slide_cache.Load(cache_key, cached_blob)) {
+            blobsize = cached_blob.size;
+            jfif_not_png = cached_blob.jfif_not_png;
 
+            if (verbose) {
+                fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d). From slide cache: %zu Bytes (%s)\n",
+                        fname.c_str(), fidx, blobsize, jfif_not_png ? "JPEG" : "PNG");
+            }
+        }
+    }
+
+    if (cached_blob.data) {
+        // nothing to do
+    }
+    else if (!raw_slide) {
+#if HAVE_MAGICKWAND
         m_wand = NewMagickWand();
 
         if (MagickReadImage(m_wand, fname.c_str()) == MagickFalse) {
@@ -423,73 +672,10 @@ bool SLSEncoder::encodeSlide(const std::string& fname, int fidx, bool raw_slides
             goto encodefile_out;
         }
 
-        size_t height       = MagickGetImageHeight(m_wand);
-        size_t width        = MagickGetImageWidth(m_wand);
-        char*  orig_format  = MagickGetImageFormat(m_wand);
-        bool   jpeg_progr   = MagickGetImageInterlaceScheme(m_wand) == JPEGInterlace;
+        blobsize = processImage(m_wand, &magick_blob, fname, fidx, &jfif_not_png, max_slide_size);
 
-        // strip unneeded information (profiles, meta data)
-        MagickStripImage(m_wand);
-
-        if (orig_format) {
-            if (strcmp(orig_format, "JPEG") == 0) {
-                size_t orig_quality = MagickGetImageCompressionQuality(m_wand);
-                native_support = true;
-
-                if (verbose) {
-                    fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d)."
-                            " Original size: %zu x %zu. (%s, q=%zu, progr=%s)\n",
-                            fname.c_str(), fidx, width, height, orig_format, orig_quality, jpeg_progr ? "y" : "n");
-                }
-            }
-            else if (strcmp(orig_format, "PNG") == 0) {
-                native_support = true;
-                jfif_not_png = false;
-
-                if (verbose) {
-                    fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d)."
-                            " Original size: %zu x %zu. (%s)\n",
-                            fname.c_str(), fidx, width, height, orig_format);
-                }
-            }
-            else if (verbose) {
-                fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d)."
-                        " Original size: %zu x %zu. (%s)\n",
-                        fname.c_str(), fidx, width, height, orig_format);
-            }
-
-            free(orig_format);
-        }
-        else {
-            fprintf(stderr, "ODR-PadEnc Warning: Unable to detect image format of '%s'\n",
-                    fname.c_str());
-
-            fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d).  Original size: %zu x %zu.\n",
-                    fname.c_str(), fidx, width, height);
-        }
-
-        if (native_support && height <= 240 && width <= 320 && not jpeg_progr) {
-            // Don't recompress the image and check if the blobsize is suitable
-            magick_blob = MagickGetImageBlob(m_wand, &blobsize);
-
-            if (blobsize <= max_slide_size) {
-                if (verbose) {
-                    fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d).  No resize needed: %zu Bytes\n",
-                            fname.c_str(), fidx, blobsize);
-                }
-                resize_required = false;
-            } else {
-                MagickRelinquishMemory(magick_blob);
-                magick_blob = NULL;
-            }
-        }
-
-        if (resize_required) {
-            blobsize = resizeImage(m_wand, &magick_blob, fname, &jfif_not_png, max_slide_size);
-        } else {
-            // warn if unresized image smaller than default dimension
-            warnOnSmallerImage(height, width, fname, false);
-        }
+        if (blobsize && !cache_key.empty())
+            slide_cache.Store(cache_key, magick_blob, blobsize, jfif_not_png);
 
 #else
         fprintf(stderr, "ODR-PadEnc has not been compiled with MagickWand, only RAW slides are supported!\n");
@@ -556,86 +742,343 @@ bool SLSEncoder::encodeSlide(const std::string& fname, int fidx, bool raw_slides
     }
 
     if (blobsize) {
-        if (raw_blob == nullptr and magick_blob == nullptr) {
-            fprintf(stderr, "ODR-PadEnc logic error: either raw_blob or magick_blob must be non-null! See src/sls.cpp line %d\n", __LINE__);
+        if (raw_blob == nullptr and magick_blob == nullptr and cached_blob.data == nullptr) {
+            fprintf(stderr, "ODR-PadEnc logic error: either raw_blob, magick_blob or cached_blob must be non-null! See src/sls.cpp line %d\n", __LINE__);
             abort();
         }
-        const uint8_t *blob = raw_blob ? raw_blob : magick_blob;
+        const uint8_t *blob = cached_blob.data ? cached_blob.data : (raw_blob ? raw_blob : magick_blob);
+
+        enqueueSlide(blob, blobsize, fidx, jfif_not_png, fname + SLS_PARAMS_SUFFIX, dump_name);
+
+        result = true;
+    }
+
+encodefile_out:
+    if (raw_blob) {
+        free(raw_blob);
+    }
 
-        MSCDG msc;
-        DATA_GROUP* dgli;
-        DATA_GROUP* mscdg;
+    if (magick_blob) {
+#if HAVE_MAGICKWAND
+        MagickRelinquishMemory(magick_blob);
+#endif
+    }
 
-        size_t nseg = blobsize / MAXSEGLEN;
-        size_t lastseglen = blobsize % MAXSEGLEN;
-        if (lastseglen)
-            nseg++;
+#if HAVE_MAGICKWAND
+    if (m_wand) {
+        m_wand = DestroyMagickWand(m_wand);
+    }
+#endif
 
-        // MOT Header
+    return result;
+}
 
-        uint8_vector_t mothdr = createMotHeader(blobsize, fidx, jfif_not_png, fname + SLS_PARAMS_SUFFIX);
-        // Create the MSC Data Group C-Structure
-        createMscDG(&msc, 3, &cindex_header, 0, 1, fidx, &mothdr[0], mothdr.size());
-        // Generate the MSC DG frame (Figure 9 en 300 401)
+
+void SLSEncoder::enqueueSegments(std::vector<DATA_GROUP*>& dgs, unsigned short int dgtype, int *cindex, unsigned short int tid, const uint8_t* data, size_t datalen, int rcount)
+{
+    MSCDG msc;
+    DATA_GROUP* dgli;
+    DATA_GROUP* mscdg;
+
+    size_t nseg = datalen / segment_size;
+    size_t lastseglen = datalen % segment_size;
+    if (lastseglen)
+        nseg++;
+
+    for (size_t i = 0; i < nseg; i++) {
+        const uint8_t *curseg = data + i * segment_size;
+        size_t curseglen;
+        int last;
+
+        if (i == nseg - 1) {
+            curseglen = lastseglen ? lastseglen : segment_size;
+            last = 1;
+        } else {
+            curseglen = segment_size;
+            last = 0;
+        }
+
+        createMscDG(&msc, dgtype, cindex, i, last, tid, curseg, curseglen, rcount);
         mscdg = packMscDG(&msc);
         dgli = PADPacketizer::CreateDataGroupLengthIndicator(mscdg->data.size());
 
-        pad_packetizer->AddDG(dgli, false);
-        pad_packetizer->AddDG(mscdg, false);
+        dgs.push_back(dgli);
+        dgs.push_back(mscdg);
+    }
+}
 
-        // MOT Body
 
-        for (size_t i = 0; i < nseg; i++) {
-            const uint8_t *curseg = blob + i * MAXSEGLEN;
-            size_t curseglen;
-            int last;
-
-            if (i == nseg - 1) {
-                curseglen = lastseglen;
-                last = 1;
-            } else {
-                curseglen = MAXSEGLEN;
-                last = 0;
+size_t SLSEncoder::shortXPADSegmentSize(size_t segment_size)
+{
+    // use the largest segment size whose DG (header + segment + CRC) completely fills its last X-PAD
+    size_t size = segment_size;
+    while (size > 1 && PADPacketizer::ShortXPADCount(9 + size + 2) == PADPacketizer::ShortXPADCount(9 + size + 2 + 1))
+        size--;
+    return size;
+}
+
+
+void SLSEncoder::setDGContinuityIndex(DATA_GROUP* dg, int cindex)
+{
+    dg->data[1] = (cindex << 4) | (dg->data[1] & 0x0F);
+
+    // CRC
+    dg->data.resize(dg->data.size() - 2);
+    dg->AppendCRC();
+}
+
+
+void SLSEncoder::beginInterleave()
+{
+    interleave = true;
+}
+
+
+void SLSEncoder::endInterleave()
+{
+    interleave = false;
+    flushObjects();
+}
+
+
+void SLSEncoder::flushObjects()
+{
+    if (objects.empty())
+        return;
+
+    std::vector<DATA_GROUP*> dgs;
+    bool interleave_directory = false;
+
+    if (mot_directory) {
+        /* MOT Directory (incl. the headers of these slides): the first copy
+         * is transmitted completely ahead of the bodies, only its repetitions
+         * are interleaved with them. */
+        uint8_vector_t motdir = createMotDirectory();
+
+        enqueueSegments(dgs, 6, &cindex_directory, directory_tid, &motdir[0], motdir.size(), repetitions);
+        if (repetitions > 0) {
+            objects.emplace_front();
+            for (int rcount = repetitions - 1; rcount >= 0; rcount--)
+                enqueueSegments(objects.front(), 6, &cindex_directory, directory_tid, &motdir[0], motdir.size(), rcount);
+            interleave_directory = true;
+        }
+
+        if (verbose)
+            fprintf(stderr, "ODR-PadEnc MOT directory: %zu objects, %zu Bytes (TransportId %d)\n",
+                    directory_entries.size(), motdir.size(), directory_tid);
+    }
+
+    // interleave the objects DG-wise (each DG together with its DGLI)
+    for (size_t i = 0;; i += 2) {
+        size_t dgs_size = dgs.size();
+        for (const std::vector<DATA_GROUP*>& object : objects) {
+            if (i < object.size()) {
+                dgs.push_back(object[i]);
+                dgs.push_back(object[i + 1]);
             }
+        }
+        if (dgs.size() == dgs_size)
+            break;
+    }
+
+    // the continuity index has to follow the (changed) order of the DGs of each type
+    if (objects.size() - (interleave_directory ? 1 : 0) > 1) {
+        cindex_header = interleave_cindex_header;
+        cindex_body = interleave_cindex_body;
 
-            createMscDG(&msc, 4, &cindex_body, i, last, fidx, curseg, curseglen);
-            mscdg = packMscDG(&msc);
-            dgli = PADPacketizer::CreateDataGroupLengthIndicator(mscdg->data.size());
+        for (DATA_GROUP* dg : dgs) {
+            if (dg->apptype_start != APPTYPE_MOT_START)
+                continue;
 
-            pad_packetizer->AddDG(dgli, false);
-            pad_packetizer->AddDG(mscdg, false);
+            int* cindex;
+            switch (dg->data[0] & 0x0F) {
+            case 3:
+                cindex = &cindex_header;
+                break;
+            case 4:
+                cindex = &cindex_body;
+                break;
+            default:
+                continue;
+            }
+
+            setDGContinuityIndex(dg, *cindex);
+            *cindex = (*cindex + 1) % 16;
         }
+    }
+
+    for (DATA_GROUP* dg : dgs)
+        dg->tag = dg_tag;
+    pad_packetizer->AddDGs(dgs, false);
+    objects.clear();
+}
+
+
+void SLSEncoder::updateDirectory(int fidx, const uint8_vector_t& mothdr)
+{
+    auto it = directory_entries.find(fidx);
+    if (it != directory_entries.end() && it->second == mothdr)
+        return;
+
+    directory_entries[fidx] = mothdr;
+
+    // a changed directory requires a new TransportId
+    directory_tid = directory_tid == DIRECTORY_TID_LAST ? DIRECTORY_TID_FIRST : directory_tid + 1;
+}
+
 
-        if (not dump_name.empty()) {
-            dump_slide(dump_name, blob, blobsize);
+void SLSEncoder::retainDirectoryObjects(const std::set<int>& fidxs)
+{
+    bool changed = false;
+    for (auto it = directory_entries.begin(); it != directory_entries.end();) {
+        if (fidxs.count(it->first)) {
+            it++;
+        } else {
+            it = directory_entries.erase(it);
+            changed = true;
         }
+    }
 
-        result = true;
+    if (changed)
+        directory_tid = directory_tid == DIRECTORY_TID_LAST ? DIRECTORY_TID_FIRST : directory_tid + 1;
+}
+
+
+uint8_vector_t SLSEncoder::createMotDirectory()
+{
+    // MOT directory (EN 301 234 v2.1.1, ch. 7.2.1), without directory extension
+    uint8_vector_t dir(13, 0x00);
+
+    for (const auto& entry : directory_entries) {
+        dir.push_back((entry.first >> 8) & 0xFF);   // TransportId
+        dir.push_back( entry.first       & 0xFF);
+        dir.insert(dir.end(), entry.second.cbegin(), entry.second.cend());
     }
 
-encodefile_out:
-    if (raw_blob) {
-        free(raw_blob);
+    // DirectorySize
+    size_t dir_size = dir.size();
+    dir[0] = (dir_size >> 24) & 0x3F;
+    dir[1] = (dir_size >> 16) & 0xFF;
+    dir[2] = (dir_size >>  8) & 0xFF;
+    dir[3] =  dir_size        & 0xFF;
+
+    // NumberOfObjects
+    dir[4] = (directory_entries.size() >> 8) & 0xFF;
+    dir[5] =  directory_entries.size()       & 0xFF;
+
+    // DataCarouselPeriod: 0 = not signalled (bytes 6-8)
+
+    // SegmentSize
+    dir[9]  = (segment_size >> 8) & 0x1F;
+    dir[10] =  segment_size       & 0xFF;
+
+    // DirectoryExtensionLength: 0 (bytes 11-12)
+
+    return dir;
+}
+
+
+void SLSEncoder::enqueueSlide(const uint8_t* blob, size_t blobsize, int fidx, bool jfif_not_png, const std::string& params_fname, const std::string& dump_name)
+{
+    uint8_vector_t mothdr = createMotHeader(blobsize, fidx, jfif_not_png, params_fname);
+
+    // the MOT directory is added when flushing the object(s)
+    if (mot_directory)
+        updateDirectory(fidx, mothdr);
+
+    if (objects.empty()) {
+        interleave_cindex_header = cindex_header;
+        interleave_cindex_body = cindex_body;
     }
+    objects.emplace_back();
+    std::vector<DATA_GROUP*>& dgs = objects.back();
+
+    // the whole object is repeated (if desired), so that the repetitions are spread in time
+    for (int rcount = repetitions; rcount >= 0; rcount--) {
+        if (!mot_directory) {
+            // MOT Header
+
+            MSCDG msc;
+            // Create the MSC Data Group C-Structure
+            createMscDG(&msc, 3, &cindex_header, 0, 1, fidx, &mothdr[0], mothdr.size(), rcount);
+            // Generate the MSC DG frame (Figure 9 en 300 401)
+            DATA_GROUP* mscdg = packMscDG(&msc);
+            DATA_GROUP* dgli = PADPacketizer::CreateDataGroupLengthIndicator(mscdg->data.size());
+
+            dgs.push_back(dgli);
+            dgs.push_back(mscdg);
+        }
 
-    if (magick_blob) {
-#if HAVE_MAGICKWAND
-        MagickRelinquishMemory(magick_blob);
-#endif
+        // MOT Body
+
+        enqueueSegments(dgs, 4, &cindex_body, fidx, blob, blobsize, rcount);
     }
 
-#if HAVE_MAGICKWAND
-    if (m_wand) {
-        m_wand = DestroyMagickWand(m_wand);
+    if (not dump_name.empty()) {
+        dump_slide(dump_name, blob, blobsize);
     }
-#endif
 
-    return result;
+    // further slides may follow, to be interleaved with this one
+    if (!interleave)
+        flushObjects();
+}
+
+
+bool SLSEncoder::encodeSlideData(const uint8_vector_t& data, int fidx, bool raw_slides, size_t max_slide_size, const std::string& dump_name)
+{
+    // slides not from a file have no name (and no params file)
+    const std::string name = "(data)";
+
+    if (raw_slides) {
+        if (verbose) {
+            fprintf(stderr, "ODR-PadEnc image: '" ODR_COLOR_SLS "%s" ODR_COLOR_RST "' (id=%d). Raw data: %zu Bytes\n",
+                    name.c_str(), fidx, data.size());
+        }
+
+        if (data.size() > max_slide_size)
+            fprintf(stderr, "ODR-PadEnc Warning: blob in raw-slide '%s' too large\n", name.c_str());
+
+        // PNG signature, otherwise JPEG
+        static const uint8_t png_signature[] = {0x89, 'P', 'N', 'G'};
+        bool jfif_not_png = !(data.size() >= sizeof(png_signature) && memcmp(&data[0], png_signature, sizeof(png_signature)) == 0);
+
+        enqueueSlide(&data[0], data.size(), fidx, jfif_not_png, "", dump_name);
+        return true;
+    }
+
+#if HAVE_MAGICKWAND
+    MagickWand *m_wand = NewMagickWand();
+    uint8_t *magick_blob = NULL;
+    size_t blobsize = 0;
+    bool jfif_not_png = true;
+
+    if (MagickReadImageBlob(m_wand, &data[0], data.size()) == MagickFalse)
+        fprintf(stderr, "ODR-PadEnc Error: Unable to load image '%s'\n", name.c_str());
+    else
+        blobsize = processImage(m_wand, &magick_blob, name, fidx, &jfif_not_png, max_slide_size);
+
+    if (blobsize)
+        enqueueSlide(magick_blob, blobsize, fidx, jfif_not_png, "", dump_name);
+
+    if (magick_blob)
+        MagickRelinquishMemory(magick_blob);
+    DestroyMagickWand(m_wand);
+
+    return blobsize > 0;
+#else
+    (void) max_slide_size;
+    fprintf(stderr, "ODR-PadEnc has not been compiled with MagickWand, only RAW slides are supported!\n");
+    return false;
+#endif
 }
 
 
 bool SLSEncoder::parse_sls_param_id(const std::string &key, const std::string &value, uint8_t &target) {
-    int value_int = atoi(value.c_str());
+    int value_int;
+    if (!parse_int(value, value_int)) {
+        fprintf(stderr, "ODR-PadEnc Warning: SLS parameter '%s' value '%s' invalid - ignored\n", key.c_str(), value.c_str());
+        return false;
+    }
     if (value_int >= 0x00 && value_int <= 0xFF) {
         target = value_int;
         return true;
@@ -726,6 +1169,33 @@ void SLSEncoder::process_mot_params_file(MOTHeader& header, const std::string &p
 }
 
 
+const uint8_vector_t& SLSEncoder::getMotParamsExtensions(const std::string &params_fname) {
+    static const uint8_vector_t no_extensions;
+
+    struct stat params_stat;
+    if (stat(params_fname.c_str(), &params_stat)) {
+        params_cache.erase(params_fname);
+        return no_extensions;
+    }
+
+    // reuse the already parsed file, if unchanged
+    auto it = params_cache.find(params_fname);
+    if (it != params_cache.end() && it->second.version == file_version_t(params_stat))
+        return it->second.extensions;
+
+    if (it == params_cache.end() && params_cache.size() >= MAXPARAMSCACHELEN)
+        params_cache.clear();
+
+    MOTHeader params_header(0, 0, 0);
+    process_mot_params_file(params_header, params_fname);
+
+    sls_params_cache_entry_t& entry = params_cache[params_fname];
+    entry.version = file_version_t(params_stat);
+    entry.extensions = params_header.GetExtensions();
+    return entry.extensions;
+}
+
+
 uint8_vector_t SLSEncoder::createMotHeader(size_t blobsize, int fidx, bool jfif_not_png, const std::string &params_fname)
 {
     // prepare ContentName
@@ -743,8 +1213,8 @@ uint8_vector_t SLSEncoder::createMotHeader(size_t blobsize, int fidx, bool jfif_
     // ContentName: XXXX.jpg / XXXX.png
     header.AddExtension(0x0C, cntemp, sizeof(cntemp) - 1);   // omit terminator
 
-    // process params file if present
-    process_mot_params_file(header, params_fname);
+    // add params file extensions if present (parsed only on change)
+    header.AddExtensions(getMotParamsExtensions(params_fname));
 
     if (verbose)
         fprintf(stderr, "ODR-PadEnc writing image as '%s'\n", cntemp + 1);
@@ -756,7 +1226,7 @@ uint8_vector_t SLSEncoder::createMotHeader(size_t blobsize, int fidx, bool jfif_
 void SLSEncoder::createMscDG(MSCDG* msc, unsigned short int dgtype,
         int *cindex, unsigned short int segnum, unsigned short int lastseg,
         unsigned short int tid, const uint8_t* data,
-        unsigned short int datalen)
+        unsigned short int datalen, unsigned char rcount)
 {
     msc->extflag = 0;
     msc->crcflag = 1;
@@ -772,7 +1242,7 @@ void SLSEncoder::createMscDG(MSCDG* msc, unsigned short int dgtype,
     msc->lenid = 2;
     msc->tid = tid;
     msc->segdata = data;
-    msc->rcount = 0;
+    msc->rcount = rcount;
     msc->seglen = datalen;
 
     *cindex = (*cindex + 1) % 16;   // increment continuity index
@@ -807,6 +1277,45 @@ DATA_GROUP* SLSEncoder::packMscDG(MSCDG* msc)
     return dg;
 }
 
+void SLSEncoder::printSegmentationOverhead(size_t slide_size) const
+{
+    if (slide_size == 0)
+        return;
+
+    // the body DGs (incl. DGLI) of a slide of the given size; their content does not matter
+    std::vector<DATA_GROUP> dgs;
+    size_t dg_bytes = 0;
+    size_t nseg = (slide_size + segment_size - 1) / segment_size;
+    for (int rcount = repetitions; rcount >= 0; rcount--) {
+        for (size_t i = 0; i < nseg; i++) {
+            size_t seglen = i == nseg - 1 ? slide_size - i * segment_size : segment_size;
+
+            DATA_GROUP mscdg(9 + seglen, APPTYPE_MOT_START, APPTYPE_MOT_CONT);
+            mscdg.AppendCRC();
+            DATA_GROUP* dgli = PADPacketizer::CreateDataGroupLengthIndicator(mscdg.data.size());
+
+            dg_bytes += dgli->data.size() + mscdg.data.size();
+            dgs.push_back(*dgli);
+            dgs.push_back(mscdg);
+            delete dgli;
+        }
+    }
+
+    pad_stats_t stats;
+    size_t pad_count = pad_packetizer->GetPADCount(dgs, &stats);
+    size_t xpad_bytes = pad_count * pad_packetizer->GetXPADSize();
+
+    fprintf(stderr, "ODR-PadEnc MOT segmentation: segment size %zu Bytes, %d repetition(s). "
+            "A slide of %zu Bytes needs %zu segment DGs (%zu Bytes incl. DGLI) in %zu X-PADs; "
+            "payload efficiency: %.1f%% of the DG bytes, %.1f%% of the X-PAD bytes\n",
+            segment_size, repetitions, slide_size, dgs.size() / 2, dg_bytes, pad_count,
+            100.0 * slide_size / dg_bytes, xpad_bytes ? 100.0 * slide_size / xpad_bytes : 0.0);
+
+    if (verbose)
+        stats.Print();
+}
+
+
 bool SLSEncoder::isSlideParamFileFilename(const std::string& filename) {
     return filename.length() >= SLS_PARAMS_SUFFIX.length() &&
            filename.substr(filename.length() - SLS_PARAMS_SUFFIX.length()) == SLS_PARAMS_SUFFIX;
@@ -42,11 +42,18 @@
 #endif
 
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <deque>
 #include <fstream>
 #include <iostream>
 #include <list>
+#include <map>
+#include <set>
 #include <algorithm>
 
 
@@ -143,6 +150,19 @@ struct fingerprint_t {
 
         this->fidx = -1;
     }
+
+    void load_from_data(const uint8_vector_t& data)
+    {
+        // slides not from a file are identified by a hash of their content
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016" PRIx64, fnv1a_64(data.data(), data.size()));
+
+        this->s_name = std::string("(data ") + hash + ")";
+        this->s_size = data.size();
+        this->s_mtime = 0;
+
+        this->fidx = -1;
+    }
 };
 
 
@@ -163,6 +183,7 @@ class History {
         void disp_database();
         // controller of id base on database
         int get_fidx(const char* filepath);
+        int get_fidx(const uint8_vector_t& data);
 
     private:
         static const size_t MAXHISTORYLEN;
@@ -182,6 +203,8 @@ class History {
         // add a new fingerprint into database
         // returns its fidx
         void add(fingerprint_t& fp);
+
+        int get_fidx(fingerprint_t& fp);
 };
 
 
@@ -198,6 +221,9 @@ public:
     bool Empty() {return slides.empty();}
     void Clear() {slides.clear();}
     slide_metadata_t GetSlide();
+    void PutBackSlide(const slide_metadata_t& slide) {slides.push_front(slide);}
+    std::set<int> GetFidxs() const;
+    int GetFidx(const uint8_vector_t& data) {return history.get_fidx(data);}
 };
 
 
@@ -216,44 +242,170 @@ public:
     MOTHeader(size_t body_size, int content_type, int content_subtype);
 
     void AddExtension(int param_id, const uint8_t* data_field, size_t data_field_len);
+    void AddExtensions(const uint8_vector_t& extensions);
     const uint8_vector_t GetData() {return data;}
+    uint8_vector_t GetExtensions() const;
+};
+
+
+// --- sls_params_cache_entry_t -----------------------------------------------------------------
+/*! The MOT header extensions derived from a slide params file.
+ * They are reused until the file changes.
+ */
+struct sls_params_cache_entry_t {
+    file_version_t version;
+    uint8_vector_t extensions;
+};
+
+
+// --- slide_cache_entry_t -----------------------------------------------------------------
+/*! A processed slide, mapped read-only from the slide cache.
+ * The mapping is released together with the entry.
+ */
+struct slide_cache_entry_t {
+    uint8_t* data;
+    size_t size;
+    bool jfif_not_png;
+
+    slide_cache_entry_t() : data(nullptr), size(0), jfif_not_png(true) {}
+    ~slide_cache_entry_t();
+
+    slide_cache_entry_t(const slide_cache_entry_t&) = delete;
+    slide_cache_entry_t& operator=(const slide_cache_entry_t&) = delete;
+};
+
+
+// --- SlideCache -----------------------------------------------------------------
+/*! An optional on-disk store of already processed (resized/recompressed)
+ * slides, which can be shared between several encoder instances that
+ * carry the same slides. So each slide has to be processed only once.
+ *
+ * Entries are named after a hash of the source file content and the
+ * encoding parameters. They are published by atomic rename, so readers
+ * never see a partially written entry.
+ */
+class SlideCache {
+private:
+    static const int FORMAT_VERSION;
+
+    std::string dir;
+
+    std::string EntryPath(const std::string& key, bool jfif_not_png) const;
+public:
+    SlideCache(const std::string& dir) : dir(dir) {}
+
+    bool Enabled() const {return !dir.empty();}
+
+    // returns an empty key, if the source file cannot be read
+    std::string GetKey(const std::string& fname, size_t max_slide_size) const;
+    bool Load(const std::string& key, slide_cache_entry_t& entry) const;
+    void Store(const std::string& key, const uint8_t* blob, size_t blobsize, bool jfif_not_png) const;
 };
 
 
 // --- SLSEncoder -----------------------------------------------------------------
+/*! Encodes slides as MOT objects, either in MOT header mode (default; a
+ * header DG per object) or in MOT directory mode (EN 301 234 v2.1.1,
+ * ch. 7.2).
+ *
+ * In directory mode, the MOT headers of all slides of the carousel are
+ * transmitted together as a MOT directory (before each slide body). As an
+ * unchanged slide keeps its TransportId (fidx), receivers that cache
+ * objects can skip bodies they already received.
+ */
 class SLSEncoder {
 private:
-    static const size_t MAXSEGLEN;
+    static const int    DIRECTORY_TID_FIRST;
+    static const int    DIRECTORY_TID_LAST;
     static const int    MINQUALITY;
     static const std::string SLS_PARAMS_SUFFIX;
+    static const size_t MAXPARAMSCACHELEN;
 
     void warnOnSmallerImage(size_t height, size_t width, const std::string& fname, bool resized);
 #if HAVE_MAGICKWAND
     size_t resizeImage(MagickWand* m_wand, unsigned char** blob, const std::string& fname, bool* jfif_not_png, size_t max_slide_size);
+    size_t processImage(MagickWand* m_wand, unsigned char** blob, const std::string& fname, int fidx, bool* jfif_not_png, size_t max_slide_size);
 #endif
     bool parse_sls_param_id(const std::string &key, const std::string &value, uint8_t &target);
     bool check_sls_param_len(const std::string &key, size_t len, size_t len_max);
     void process_mot_params_file(MOTHeader& header, const std::string &params_fname);
+    const uint8_vector_t& getMotParamsExtensions(const std::string &params_fname);
     uint8_vector_t createMotHeader(size_t blobsize, int fidx, bool jfif_not_png, const std::string &params_fname);
     void createMscDG(MSCDG* msc, unsigned short int dgtype,
             int *cindex, unsigned short int segnum, unsigned short int lastseg,
             unsigned short int tid, const uint8_t* data,
-            unsigned short int datalen);
-    DATA_GROUP* packMscDG(MSCDG* msc);
+            unsigned short int datalen, unsigned char rcount);
+    void enqueueSegments(std::vector<DATA_GROUP*>& dgs, unsigned short int dgtype, int *cindex, unsigned short int tid, const uint8_t* data, size_t datalen, int rcount);
+    static void setDGContinuityIndex(DATA_GROUP* dg, int cindex);
+    static size_t shortXPADSegmentSize(size_t segment_size);
+    void flushObjects();
+    void updateDirectory(int fidx, const uint8_vector_t& mothdr);
+    uint8_vector_t createMotDirectory();
+    void enqueueSlide(const uint8_t* blob, size_t blobsize, int fidx, bool jfif_not_png, const std::string& params_fname, const std::string& dump_name);
 
     PADPacketizer* pad_packetizer;
+    SlideCache slide_cache;
+    size_t segment_size;
+    int repetitions;
+    std::map<std::string, sls_params_cache_entry_t> params_cache;
     int cindex_header;
     int cindex_body;
+
+    bool mot_directory;
+    std::map<int, uint8_vector_t> directory_entries;    // fidx -> MOT header
+    int cindex_directory;
+    int directory_tid;
+
+    bool interleave;
+    std::deque<std::vector<DATA_GROUP*>> objects;   // DGs (each with DGLI) of the not yet enqueued objects
+    int interleave_cindex_header;
+    int interleave_cindex_body;
+    int dg_tag;
 public:
+    static const size_t MAXSEGLEN;
+    static const size_t MAXSEGLEN_LIMIT;
+    static const int    MAXREPETITIONS;
     static const size_t MAXSLIDESIZE_SIMPLE;
     static const int APPTYPE_MOT_START;
     static const int APPTYPE_MOT_CONT;
     static const std::string REQUEST_REREAD_FILENAME;
 
-    SLSEncoder(PADPacketizer* pad_packetizer) : pad_packetizer(pad_packetizer), cindex_header(0), cindex_body(0) {}
+    SLSEncoder(PADPacketizer* pad_packetizer, const std::string& slide_cache_dir = "", bool mot_directory = false,
+            size_t segment_size = MAXSEGLEN, int repetitions = 0) :
+        pad_packetizer(pad_packetizer), slide_cache(slide_cache_dir), segment_size(segment_size), repetitions(repetitions),
+        cindex_header(0), cindex_body(0), mot_directory(mot_directory), cindex_directory(0), directory_tid(DIRECTORY_TID_FIRST),
+        interleave(false), interleave_cindex_header(0), interleave_cindex_body(0), dg_tag(0) {
+        if (pad_packetizer->IsShortXPAD()) {
+            this->segment_size = shortXPADSegmentSize(segment_size);
+
+            // (the default is adapted silently)
+            if (this->segment_size != segment_size && segment_size != MAXSEGLEN)
+                fprintf(stderr, "ODR-PadEnc Warning: MOT segment size %zu reduced to %zu, to fill the last short X-PAD of each segment\n",
+                        segment_size, this->segment_size);
+        }
+    }
+
+    /*! Slides encoded between these calls are enqueued interleaved (DG-wise),
+     * so that several (small) slides are transmitted concurrently.
+     */
+    void beginInterleave();
+    void endInterleave();
+
+    /*! The DGs of slides encoded afterwards get this tag (see DATA_GROUP::tag),
+     * e.g. to remove them from the PADPacketizer queue selectively.
+     */
+    void setDGTag(int tag) {dg_tag = tag;}
 
     bool encodeSlide(const std::string& fname, int fidx, bool raw_slides, size_t max_slide_size, const std::string& dump_name);
+    bool encodeSlideData(const uint8_vector_t& data, int fidx, bool raw_slides, size_t max_slide_size, const std::string& dump_name);
     static bool isSlideParamFileFilename(const std::string& filename);
+    static DATA_GROUP* packMscDG(MSCDG* msc);
+
+    // MOT directory mode only: removes all objects that are no longer part of the carousel
+    void retainDirectoryObjects(const std::set<int>& fidxs);
+
+    // prints the overhead of the segment size/repetitions for a slide of the given size
+    void printSegmentationOverhead(size_t slide_size) const;
 };
 
 #endif /* SLS_H_ */